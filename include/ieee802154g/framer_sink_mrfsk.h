@@ -37,6 +37,10 @@ namespace gr {
      *  msg_queue.type() is always 0 for uncoded
      *  msg_queue.arg1() contains PHR (PHY header)
      *  msg_queue.arg2() is 1 for good CRC, or 0 for CRC calculation mismatch
+     *  target_queue may be null. Each frame is also published on message
+     *  port "pdus" as (metadata . u8vector), the PSDU without FCS; metadata
+     *  holds "phr", "fec_en", "dw", "crc_type_16", "crc_ok" and "length",
+     *  the PSDU length in octets including FCS.
      */
     class IEEE802154G_API framer_sink_mrfsk : virtual public gr::sync_block
     {
@@ -48,6 +52,70 @@ namespace gr {
        * \param target_queue the message queue for parsed packets
        */
       static sptr make(msg_queue::sptr target_queue);
+
+      /*!
+       * \brief create instance of MR-FSK uncoded framer, packed input
+       *
+       * Input is 8 bits per item, MSbit first, instead of one bit per
+       * item with correlator flag. A stream tag named sync_tag goes on the
+       * item holding the first bit after SFD; its integer value is the
+       * position of that bit counted from the MSbit (0..7).
+       *
+       * \param target_queue the message queue for parsed packets
+       * \param sync_tag key of SFD stream tags
+       */
+      static sptr make(msg_queue::sptr target_queue, const std::string &sync_tag);
+
+      /*!
+       * \brief Drop frames instead of waiting when target_queue is full
+       *
+       * Frames are published on message port "pdus" regardless, which
+       * never holds up the receive chain.
+       */
+      virtual void set_lossy(bool lossy) = 0;
+
+      /*!
+       * \brief Number of frames dropped from target_queue in lossy mode
+       */
+      virtual uint64_t dropped() const = 0;
+
+      /*!
+       * \brief Longest PSDU accepted, in octets
+       *
+       * A PHR announcing more, or with MS or reserved bits set, or too
+       * short for its FCS, is taken as a false sync and search resumes.
+       */
+      virtual void set_max_frame_length(int max_frame_length) = 0;
+
+      /*!
+       * \brief Let a new SFD cut short a frame in progress
+       *
+       * A correlator flag, or with packed input an SFD tag, inside a frame
+       * drops that frame and starts on the new one.
+       */
+      virtual void set_preempt(bool preempt) = 0;
+
+      /*!
+       * \brief Receive counters since the block was made
+       *
+       * SFDs found by code, frames dropped at PHR, FCS results by CRC type
+       * and PSDU octets, less FCS, of the frames sent. Safe to read from
+       * any thread. Also sent as a dict on message port "stats", and
+       * exported over ControlPort when built with it.
+       */
+      virtual uint64_t sfd_uncoded() const = 0;
+      virtual uint64_t sfd_nrnsc() const = 0;
+      virtual uint64_t phr_rejects() const = 0;
+      virtual uint64_t crc16_ok() const = 0;
+      virtual uint64_t crc16_fail() const = 0;
+      virtual uint64_t crc32_ok() const = 0;
+      virtual uint64_t crc32_fail() const = 0;
+      virtual uint64_t octets() const = 0;
+
+      /*!
+       * \brief Seconds between dicts on message port "stats", 0 (default) for none
+       */
+      virtual void set_stats_interval(double seconds) = 0;
     };
 
   } // namespace ieee802154g
@@ -0,0 +1,71 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_MRFSK_MOD_H
+#define INCLUDED_IEEE802154G_MRFSK_MOD_H
+
+#include <ieee802154g/api.h>
+#include <gnuradio/sync_interpolator.h>
+
+namespace gr {
+  namespace ieee802154g {
+
+    /*!
+     * \brief MR-FSK GFSK modulator with PA ramp
+     * \ingroup ieee802154g
+     *
+     * \details
+     * Packed octets from mrfsk_source in, complex baseband out, 8*sps
+     * samples per octet. Same waveform as digital.gfsk_mod followed by
+     * pa_ramp, in one pass: "pa_ramp" tags switch the transmitter on and off.
+     * Burst tags from mrfsk_source are carried onto the samples: tx_eob
+     * lands on the last sample of its octet, packet_len counts samples.
+     */
+    class IEEE802154G_API mrfsk_mod : virtual public gr::sync_interpolator
+    {
+     public:
+      typedef boost::shared_ptr<mrfsk_mod> sptr;
+
+      /*!
+       * \brief create a new instance of MR-FSK modulator
+       *
+       * \param sps     samples per symbol
+       * \param mod_index   modulation index h, sensitivity is pi*h/sps
+       * \param bt      Gaussian filter bandwidth-time product, 0.5 for MR-FSK
+       * \param rm      power gain factor during transmit
+       * \param steps   number of samples to ramp between zero power and TX power
+       */
+      static sptr make(int sps, float mod_index, float bt, float rm, int steps);
+
+      /*!
+       * \brief Set the multipication factor during packet transmit
+       */
+      virtual void set_k(float rm) = 0;
+
+      /*!
+       * \brief Set the number of samples between zero power and TX power
+       */
+      virtual void set_steps(int s) = 0;
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_MRFSK_MOD_H */
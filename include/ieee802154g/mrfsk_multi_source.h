@@ -0,0 +1,85 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_IEEE802154G_MRFSK_MULTI_SOURCE_H
+#define INCLUDED_IEEE802154G_MRFSK_MULTI_SOURCE_H
+
+#include <ieee802154g/api.h>
+#include <gnuradio/sync_block.h>
+#include <vector>
+
+namespace gr {
+  namespace ieee802154g {
+
+    /*!
+     * \brief Many MR-FSK transmitters on one wideband output
+     * \ingroup ieee802154g
+     *
+     * \details
+     * One channel per entry of freq_offsets. Each channel sends the same
+     * stream as mrfsk_source (incrementing octet payload) into mrfsk_mod,
+     * with its own modulator and PA ramp state, shifted to its offset.
+     * Channels are summed into complex baseband at samp_rate. Channel n
+     * starts n/N of a frame period after channel 0, so that they do not
+     * all key up together.
+     */
+    class IEEE802154G_API mrfsk_multi_source : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<mrfsk_multi_source> sptr;
+
+      /*!
+       * \brief create a new instance of multi-channel MR-FSK source
+       *
+       * \param sps     samples per symbol
+       * \param mod_index   modulation index h, sensitivity is pi*h/sps
+       * \param bt      Gaussian filter bandwidth-time product, 0.5 for MR-FSK
+       * \param samp_rate   output sample rate, symbol rate times sps
+       * \param freq_offsets    channel centers relative to output center, in Hz
+       * \param preamble_size   number of preamble octets
+       * \param fec_en  enable NRNSC FEC
+       * \param dw      enable data whitening
+       * \param crc_type_16 FCS type: CRC16 if true, CRC32 if false
+       * \param psdu_len    PSDU length including FCS
+       * \param delay_bytes time between packets, in octets
+       * \param rm      power gain factor of each channel during transmit
+       * \param steps   number of samples to ramp between zero power and TX power
+       */
+      static sptr make(int sps, float mod_index, float bt, double samp_rate,
+              const std::vector<float> &freq_offsets, int preamble_size,
+              bool fec_en, bool dw, bool crc_type_16, int psdu_len,
+              int delay_bytes, float rm, int steps);
+
+      /*!
+       * \brief Set the multipication factor of each channel during packet transmit
+       */
+      virtual void set_k(float rm) = 0;
+
+      /*!
+       * \brief Move one channel, offset in Hz from output center
+       */
+      virtual void set_freq_offset(int channel, float offset) = 0;
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_MRFSK_MULTI_SOURCE_H */
@@ -0,0 +1,114 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_MRFSK_SOFT_DEFRAMER_H
+#define INCLUDED_IEEE802154G_MRFSK_SOFT_DEFRAMER_H
+
+#include <ieee802154g/api.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/msg_queue.h>
+
+namespace gr {
+  namespace ieee802154g {
+
+    /*!
+     * \brief MR-FSK deframer with soft decision Viterbi for NRNSC frames
+     * \ingroup ieee802154g
+     *
+     * \details
+     *  Input is one float per symbol, e.g. the quadrature demod output at
+     *  the symbol instant, positive for a one. SFD search is as for
+     *  mrfsk_deframer on the signs. Uncoded frames are decoded from the
+     *  signs; FEC frames by a Viterbi decoder on the soft values, scaled by
+     *  the mean magnitude of the symbols before SFD.
+     *  msg_queue.type() is 0 for uncoded, 1 for NRNSC
+     *  msg_queue.arg1() contains PHR (PHY header)
+     *  msg_queue.arg2() is 1 for good CRC, or 0 for CRC calculation mismatch
+     *  target_queue may be null. Each frame is also published on message
+     *  port "pdus" as (metadata . u8vector), the PSDU without FCS; metadata
+     *  holds "phr", "fec_en", "dw", "crc_type_16", "crc_ok" and "length",
+     *  the PSDU length in octets including FCS.
+     */
+    class IEEE802154G_API mrfsk_soft_deframer : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<mrfsk_soft_deframer> sptr;
+
+      /*!
+       * \brief create instance of MR-FSK soft decision deframer
+       * \param target_queue the message queue for parsed packets
+       * \param preamble_bits how many preamble bits before SFD must match, 0..48
+       * \param threshold bit errors allowed in preamble bits plus SFD
+       */
+      static sptr make(msg_queue::sptr target_queue, int preamble_bits, int threshold);
+
+      /*!
+       * \brief Drop frames instead of waiting when target_queue is full
+       */
+      virtual void set_lossy(bool lossy) = 0;
+
+      /*!
+       * \brief Number of frames dropped from target_queue in lossy mode
+       */
+      virtual uint64_t dropped() const = 0;
+
+      /*!
+       * \brief Longest PSDU accepted, in octets
+       *
+       * A PHR announcing more, or with MS or reserved bits set, or too
+       * short for its FCS, is taken as a false sync and search resumes.
+       */
+      virtual void set_max_frame_length(int max_frame_length) = 0;
+
+      /*!
+       * \brief Let a new SFD cut short a frame in progress
+       *
+       * SFD search keeps running during a frame; preamble bits plus SFD
+       * matching exactly drop that frame and start on the new one.
+       */
+      virtual void set_preempt(bool preempt) = 0;
+
+      /*!
+       * \brief Receive counters since the block was made
+       *
+       * SFDs found by code, frames dropped at PHR, FCS results by CRC type
+       * and PSDU octets, less FCS, of the frames sent. Safe to read from
+       * any thread. Also sent as a dict on message port "stats", and
+       * exported over ControlPort when built with it.
+       */
+      virtual uint64_t sfd_uncoded() const = 0;
+      virtual uint64_t sfd_nrnsc() const = 0;
+      virtual uint64_t phr_rejects() const = 0;
+      virtual uint64_t crc16_ok() const = 0;
+      virtual uint64_t crc16_fail() const = 0;
+      virtual uint64_t crc32_ok() const = 0;
+      virtual uint64_t crc32_fail() const = 0;
+      virtual uint64_t octets() const = 0;
+
+      /*!
+       * \brief Seconds between dicts on message port "stats", 0 (default) for none
+       */
+      virtual void set_stats_interval(double seconds) = 0;
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_MRFSK_SOFT_DEFRAMER_H */
@@ -29,6 +29,7 @@
 #define PAYLOAD_TYPE_PN9        1   // TUV conformance
 #define PAYLOAD_TYPE_CRC_TEST   2
 #define PAYLOAD_PN9_FOREVER     3   // not packet, LFSR only
+#define PAYLOAD_PN15_FOREVER    4   // not packet, x^15 + x^14 + 1
 
 namespace gr {
   namespace ieee802154g {
@@ -48,12 +49,12 @@ namespace gr {
       /*!  \brief create instance of MR-FSK packet generator
        *
        * \param num_iterations How many packets to sent
-       * \param preamble_size Length of preamble in octets
+       * \param preamble_size Length of preamble in octets, negative taken as 0
        * \param fec_en enables FEC NRNSC encoding
        * \param dw enables PN9 whitening of PSDU
        * \param crc_type_16 selects CRC type
        * \param payload_type content of PSDU payload, see PAYLOAD_* definitions
-       * \param psdu_len length of PSDU in octets (including MFR/CRC)
+       * \param psdu_len length of PSDU in octets (including MFR/CRC), at most 2047
        * \param delay_bytes slows rate of packets: length of time between packtes in octets, during which TX power is off
        */
       static sptr make(
@@ -66,6 +67,77 @@ namespace gr {
         int psdu_len,
         int delay_bytes
       );
+
+      /*!  \brief create instance of MR-FSK packet generator fed by PDUs
+       *
+       * PDUs arrive on message port "pdus" as (metadata . u8vector), the
+       * u8vector being the PSDU without FCS. Each is encoded on arrival into
+       * a bounded queue of over-the-air frames, which are sent back-to-back.
+       * Metadata keys "fec_en", "dw" and "crc_type_16" (bool) override the
+       * settings below for that frame. PDUs arriving when the queue is full
+       * are dropped, and counted in pdus_dropped(). Between frames the
+       * output idles at zero.
+       *
+       * \param preamble_size Length of preamble in octets
+       * \param fec_en enables FEC NRNSC encoding
+       * \param dw enables PN9 whitening of PSDU
+       * \param crc_type_16 selects CRC type
+       * \param delay_bytes time between packets in octets, during which TX power is off
+       * \param queue_depth number of encoded frames which can be waiting
+       */
+      static sptr make(
+        int preamble_size,
+        bool fec_en,
+        bool dw,
+        bool crc_type_16,
+        int delay_bytes,
+        int queue_depth
+      );
+
+      /*!
+       * The over-the-air frame is built once and repeated until one of
+       * the frame setters below is called; changes take effect from the
+       * next packet, the packet being sent is not disturbed.
+       */
+      virtual void set_preamble_size(int preamble_size) = 0;
+      virtual void set_fec_en(bool fec_en) = 0;
+      virtual void set_dw(bool dw) = 0;
+      virtual void set_crc_type_16(bool crc_type_16) = 0;
+      /*!
+       * \brief Set content of PSDU payload, see PAYLOAD_* definitions
+       * PAYLOAD_PN9_FOREVER and PAYLOAD_PN15_FOREVER are only honored
+       * before the first packet.
+       */
+      virtual void set_payload_type(char payload_type) = 0;
+      virtual void set_psdu_len(int psdu_len) = 0;
+
+      /*!
+       * \brief Set time between packets in octets, from the next packet
+       */
+      virtual void set_delay_bytes(int delay_bytes) = 0;
+
+      /*!
+       * \brief Stream bursts instead of a continuous signal
+       *
+       * In burst mode the octets before the first packet and between
+       * packets are not produced. Each packet (plus its pad and PA ramp
+       * down octets) is tagged tx_sob, packet_len and tx_eob for the UHD
+       * sink, and with start_time > 0 also tx_time: the first burst at
+       * start_time, each next one delay_bytes after the previous ended,
+       * as in the continuous signal. A PDU may carry its own "tx_time"
+       * (uint64 seconds, double fraction) in metadata, which the schedule
+       * then continues from.
+       *
+       * \param burst enables burst mode
+       * \param symbol_rate in symbols per second, for tx_time
+       * \param start_time radio time of first burst in seconds, 0 for untimed
+       */
+      virtual void set_burst_mode(bool burst, double symbol_rate, double start_time) = 0;
+
+      /*!
+       * \brief PDUs dropped for want of room in the frame queue
+       */
+      virtual uint64_t pdus_dropped() const = 0;
     };
 
   } // namespace ieee802154g
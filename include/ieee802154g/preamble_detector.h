@@ -44,9 +44,56 @@ namespace gr {
 
       /*!
        * \brief create new instance of 2-(G)FSK preamble detector
-       * \param samples_per_symbol bit_rate = samp_rate / samples_per_symbol
+       * \param samples_per_symbol bit_rate = samp_rate / samples_per_symbol;
+       *        4, 5, 8, 10 and 16 get kernels made for that window length
        */
       static sptr make(int samples_per_symbol);
+
+      /*!
+       * \brief create new instance of 2-(G)FSK preamble detector, lock thresholds given
+       *
+       * The detector counts 2-UI windows that look like preamble, less
+       * those that don't. Shorter preambles are caught with lower counts,
+       * at the cost of more false locks on data and noise.
+       *
+       * \param samples_per_symbol bit_rate = samp_rate / samples_per_symbol
+       * \param avg_windows count past which zero crossings are averaged (3)
+       * \param lock_windows count past which the sample point follows them,
+       *        a lock (6); at least avg_windows
+       * \param drift_windows taken off the count for a window whose mid
+       *        level moved too far, 0 for none (4)
+       * \param freq_tolerance how far is too far, as fraction of the
+       *        window's peak to peak (0.1)
+       */
+      static sptr make(int samples_per_symbol, int avg_windows, int lock_windows,
+          int drift_windows, float freq_tolerance);
+
+      /*!
+       * \brief Lock thresholds as for make(); throws std::out_of_range
+       */
+      virtual void set_thresholds(int avg_windows, int lock_windows,
+          int drift_windows, float freq_tolerance) = 0;
+      virtual int avg_windows() const = 0;
+      virtual int lock_windows() const = 0;
+      virtual int drift_windows() const = 0;
+      virtual float freq_tolerance() const = 0;
+
+      /*!
+       * \brief Preamble locks taken since the block was made
+       *
+       * A lock is when the sample point starts following the preamble.
+       * One lost again within an octet counts as false as well, no
+       * preamble being that short. Safe to read from any thread; also
+       * sent as a dict on message port "stats", and exported over
+       * ControlPort when built with it.
+       */
+      virtual uint64_t locks() const = 0;
+      virtual uint64_t false_locks() const = 0;
+
+      /*!
+       * \brief Seconds between dicts on message port "stats", 0 (default) for none
+       */
+      virtual void set_stats_interval(double seconds) = 0;
     };
 
   } // namespace ieee802154g
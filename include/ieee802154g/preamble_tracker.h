@@ -0,0 +1,74 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_PREAMBLE_TRACKER_H
+#define INCLUDED_IEEE802154G_PREAMBLE_TRACKER_H
+
+#include <ieee802154g/api.h>
+#include <gnuradio/block.h>
+
+namespace gr {
+  namespace ieee802154g {
+
+    /*!
+     * \brief Preamble detector for 2-(G)FSK that keeps timing through the frame
+     * \ingroup ieee802154g
+     * \details
+     * As preamble_detector, this block is driven by quadrature demodulator
+     * and outputs one sample per symbol to binary slicer, with bit-phase and
+     * frequency offset taken from 0xaa/0x55 preamble. After the preamble the
+     * sample point follows the data: at each transition between symbols the
+     * signal midway should cross zero, and where it does instead moves the
+     * sample point by loop_gain of the difference. To keep up with a
+     * transmitter clock off by some ppm, sps-1 to sps+1 input samples are
+     * taken per symbol, so long frames don't walk off the sample point.
+     */
+    class IEEE802154G_API preamble_tracker : virtual public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<preamble_tracker> sptr;
+
+      /*!
+       * \brief create new instance of 2-(G)FSK preamble detector with tracking
+       * \param samples_per_symbol bit_rate = samp_rate / samples_per_symbol
+       * \param loop_gain fraction of timing error corrected per 2 symbols, 0 for none
+       */
+      static sptr make(int samples_per_symbol, float loop_gain);
+
+      virtual void set_loop_gain(float loop_gain) = 0;
+
+      /*!
+       * \brief Preamble locks taken since the block was made
+       *
+       * As preamble_detector::locks().
+       */
+      virtual uint64_t locks() const = 0;
+      virtual uint64_t false_locks() const = 0;
+
+      /*!
+       * \brief Seconds between dicts on message port "stats", 0 (default) for none
+       */
+      virtual void set_stats_interval(double seconds) = 0;
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_PREAMBLE_TRACKER_H */
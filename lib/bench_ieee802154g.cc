@@ -0,0 +1,576 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 wroberts92780@gmail.com
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ *
+ *************************************************************************************
+ * Micro-benchmarks for the MR-FSK kernels and the receive hot loops.
+ *
+ *   bench_ieee802154g [-i iterations] [-s sps] [-o file.json] [frame_len ...]
+ *   bench_ieee802154g -p [-i frames] [-s sps] [-n noise] [-t avg,lock,drift,tol] [-o file.json]
+ *
+ * frame_len is PSDU length in octets (default 16 127 2047, max aMaxPHYPacketSize).
+ * Results are written as JSON (stdout by default): ns per PSDU octet and Mbit/s.
+ * With -p, preamble_detector's detection probability and false locks per
+ * frame against preamble length instead, for the lock thresholds of -t
+ * (default 3,6,4,0.1) and demod noise of -n (default 0.01, signal +-0.1).
+ */
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/top_block.h>
+#include <gnuradio/high_res_timer.h>
+#include <ieee802154g/mrfsk_source.h>
+#include <ieee802154g/framer_sink_mrfsk.h>
+#include <ieee802154g/framer_sink_mrfsk_nrnsc.h>
+#include <ieee802154g/mrfsk_soft_deframer.h>
+#include <ieee802154g/preamble_detector.h>
+#include "utils_mrfsk.h"
+#include "mrfsk_modulator.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace gr::ieee802154g;
+
+/* items per work() call, about what the scheduler hands a block */
+#define WORK_CHUNK      4096
+
+typedef struct {
+    std::string name;
+    int frame_len;
+    double ns_per_byte;
+    double mbps;
+} result_t;
+
+static std::vector<result_t> results;
+static volatile unsigned int sink_val;   // keeps results of kernels live
+
+static double
+now()
+{
+    return (double)gr::high_res_timer_now() / gr::high_res_timer_tps();
+}
+
+static void
+report(const char *name, int frame_len, double secs, double bytes)
+{
+    result_t r;
+    r.name = name;
+    r.frame_len = frame_len;
+    r.ns_per_byte = secs * 1e9 / bytes;
+    r.mbps = bytes * 8 / secs / 1e6;
+    results.push_back(r);
+    fprintf(stderr, "%-28s %5d  %8.3f ns/byte  %9.2f Mbit/s\n", name, frame_len, r.ns_per_byte, r.mbps);
+}
+
+/* discards everything, for running a source in a flowgraph */
+class bench_sink : public gr::sync_block
+{
+ public:
+    bench_sink() : gr::sync_block("bench_sink",
+        gr::io_signature::make(1, 1, sizeof(unsigned char)),
+        gr::io_signature::make(0, 0, 0)) {}
+
+    int work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+        return noutput_items;
+    }
+};
+
+/* NRNSC encoder of 18.1.2.4, stimulus only */
+static void
+nrnsc_encode_bits(std::vector<uint8_t> &bits, const uint8_t *in, int len)
+{
+    int i, bp, m0 = 0, m1 = 0, m2 = 0, b = 0;
+
+    for (i = 0; i < len; i++) {
+        for (bp = 0x80; bp != 0; bp >>= 1) {
+            m2 = m1;
+            m1 = m0;
+            m0 = b;
+            b = (in[i] & bp) ? 1 : 0;
+            bits.push_back(!(b ^ m1 ^ m2));
+            bits.push_back(!(b ^ m0 ^ m1 ^ m2));
+        }
+    }
+}
+
+/* PHR + PSDU with 32bit FCS, whitened */
+static std::vector<uint8_t>
+make_phr_psdu(int frame_len)
+{
+    std::vector<uint8_t> buf(PHR_LENGTH + frame_len);
+    MRFSK_PHR_t phr;
+    uint8_t *psdu = &buf[PHR_LENGTH];
+    uint16_t lfsr = PN9_SEED;
+    uint32_t crc;
+    int i;
+
+    phr.word = 0;
+    phr.bits.DW = 1;
+    phr.bits.FCS = 0;
+    phr.bits.frame_length = frame_len;
+    buf[0] = phr.word >> 8;
+    buf[1] = phr.word & 0xff;
+
+    for (i = 0; i < frame_len - 4; i++)
+        psdu[i] = rand();
+    crc = ~digital_update_crc32(INITIAL_CRC32, psdu, frame_len - 4);
+    psdu[i++] = crc >> 24;
+    psdu[i++] = crc >> 16;
+    psdu[i++] = crc >> 8;
+    psdu[i++] = crc;
+    pn9_xor(psdu, frame_len, &lfsr);
+
+    return buf;
+}
+
+/* one unpacked bit per item, as from correlate_access_code_bb */
+static void
+append_bits(std::vector<uint8_t> &stream, const std::vector<uint8_t> &bits)
+{
+    size_t i;
+
+    for (i = 0; i < 64; i++)
+        stream.push_back(i & 1);    // idle between frames
+    for (i = 0; i < bits.size(); i++)
+        stream.push_back(bits[i] | (i == 0 ? 2 : 0));   // flag: first bit after SFD
+}
+
+static void
+bench_kernels(int frame_len, int iterations)
+{
+    std::vector<uint8_t> buf(frame_len + 4);
+    std::vector<uint8_t> coded(2 * frame_len);
+    unsigned int acc = 0;
+    double t;
+    int it, i;
+
+    for (i = 0; i < (int)buf.size(); i++)
+        buf[i] = rand();
+
+    t = now();
+    for (it = 0; it < iterations; it++)
+        acc += digital_update_crc32(INITIAL_CRC32, &buf[0], frame_len);
+    report("digital_update_crc32", frame_len, now() - t, (double)frame_len * iterations);
+
+    t = now();
+    for (it = 0; it < iterations; it++)
+        acc += crc_msb_first(INITIAL_CRC16, &buf[0], frame_len);
+    report("crc_msb_first", frame_len, now() - t, (double)frame_len * iterations);
+
+    t = now();
+    for (it = 0; it < iterations; it++) {
+        uint16_t lfsr = PN9_SEED;
+        for (i = 0; i < frame_len; i++)
+            acc += get_pn9_byte(&lfsr);
+    }
+    report("get_pn9_byte", frame_len, now() - t, (double)frame_len * iterations);
+
+    t = now();
+    for (it = 0; it < iterations; it++) {
+        uint16_t lfsr = PN9_SEED;
+        pn9_xor(&buf[0], frame_len, &lfsr);
+    }
+    acc += buf[0];
+    report("pn9_xor", frame_len, now() - t, (double)frame_len * iterations);
+
+    t = now();
+    for (it = 0; it < iterations; it++) {
+        for (i = 0; i + 4 <= frame_len; i += 4)
+            interleave(&buf[i]);
+    }
+    acc += buf[0];
+    report("interleave", frame_len, now() - t, (double)(frame_len & ~3) * iterations);
+
+    t = now();
+    for (it = 0; it < iterations; it++)
+        interleave_frame(&buf[0], frame_len & ~3);
+    acc += buf[0];
+    report("interleave_frame", frame_len, now() - t, (double)(frame_len & ~3) * iterations);
+
+    t = now();
+    for (it = 0; it < iterations; it++)
+        acc += nrnsc_encode(&coded[0], &buf[0], frame_len, NRNSC_STATE_INIT);
+    acc += coded[0];
+    report("nrnsc_encode", frame_len, now() - t, (double)frame_len * iterations);
+
+    /* soft bits of the coded octets above, 8 trellis steps per octet in */
+    std::vector<int8_t> soft(16 * frame_len);
+    std::vector<uint8_t> decisions(8 * frame_len);
+    int16_t metric[NRNSC_STATES];
+    for (i = 0; i < 16 * frame_len; i++)
+        soft[i] = ((coded[i >> 3] >> (7 - (i & 7))) & 1 ? 40 : -40) + (rand() % 41) - 20;
+    t = now();
+    for (it = 0; it < iterations; it++) {
+        nrnsc_viterbi_init(metric, NRNSC_STATE_INIT);
+        nrnsc_viterbi_acs(metric, &decisions[0], &soft[0], 8 * frame_len);
+        nrnsc_viterbi_traceback(&buf[0], &decisions[0], 8 * frame_len, nrnsc_viterbi_best(metric));
+    }
+    acc += buf[0];
+    report("nrnsc_viterbi", frame_len, now() - t, (double)frame_len * iterations);
+
+    t = now();
+    for (it = 0; it < iterations; it++) {
+        for (i = 0; i < frame_len; i++)
+            acc += reverse_octet(buf[i]);
+    }
+    report("reverse_octet", frame_len, now() - t, (double)frame_len * iterations);
+
+    sink_val = acc;
+}
+
+/* over-the-air generation, FEC on, including scheduler */
+static void
+bench_source(int frame_len, int iterations)
+{
+    gr::top_block_sptr tb = gr::make_top_block("bench_source");
+    mrfsk_source::sptr src = mrfsk_source::make(iterations, 4, true, true, false,
+        PAYLOAD_TYPE_PN9, frame_len, 0);
+    gr::block_sptr snk = gnuradio::get_initial_sptr(new bench_sink());
+    double t;
+
+    tb->connect(src, 0, snk, 0);
+    t = now();
+    tb->run();
+    report("mrfsk_source nrnsc encode", frame_len, now() - t, (double)frame_len * iterations);
+}
+
+/* GFSK modulation of over-the-air octets, TX power on */
+static void
+bench_mod(int frame_len, int iterations, int sps)
+{
+    mrfsk_modulator mod(sps, 1.0, 0.5);
+    std::vector<uint8_t> buf(frame_len);
+    std::vector<gr_complex> out(frame_len * 8 * sps);
+    double t;
+    int it, i;
+
+    for (i = 0; i < frame_len; i++)
+        buf[i] = rand();
+
+    t = now();
+    for (it = 0; it < iterations; it++)
+        mod.modulate(&buf[0], frame_len, &out[0], 1.0);
+    sink_val = (unsigned int)out[0].real();
+    report("mrfsk_modulator", frame_len, now() - t, (double)frame_len * iterations);
+}
+
+/* feeds stream through work() in scheduler-sized chunks */
+template <class T>
+static double
+run_sink(gr::sync_block *blk, const std::vector<T> &stream, gr::msg_queue::sptr q)
+{
+    gr_vector_const_void_star input_items(1);
+    gr_vector_void_star output_items;
+    size_t pos, n;
+    double t = now();
+
+    for (pos = 0; pos < stream.size(); pos += n) {
+        n = stream.size() - pos;
+        if (n > WORK_CHUNK)
+            n = WORK_CHUNK;
+        input_items[0] = &stream[pos];
+        blk->work(n, input_items, output_items);
+        q->flush();
+    }
+
+    return now() - t;
+}
+
+static void
+bench_framers(int frame_len, int iterations)
+{
+    std::vector<uint8_t> phr_psdu = make_phr_psdu(frame_len);
+    std::vector<uint8_t> bits, coded, stream;
+    gr::msg_queue::sptr q = gr::msg_queue::make(0);
+    int i, bp, it;
+
+    for (i = 0; i < (int)phr_psdu.size(); i++) {
+        for (bp = 0x80; bp != 0; bp >>= 1)
+            bits.push_back((phr_psdu[i] & bp) ? 1 : 0);
+    }
+
+    /* NRNSC: tail, pad, then interleave */
+    std::vector<uint8_t> tail_pad(phr_psdu);
+    tail_pad.push_back(0x0b);   // 3 tail + 5 pad bits
+    if ((phr_psdu.size() & 1) == 0)
+        tail_pad.push_back(0x0b);   // 13 pad bits
+    nrnsc_encode_bits(coded, &tail_pad[0], tail_pad.size());
+    for (i = 0; i + 32 <= (int)coded.size(); i += 32) {
+        uint8_t blk[4] = { 0, 0, 0, 0 };
+        for (bp = 0; bp < 32; bp++)
+            blk[bp >> 3] |= coded[i + bp] << (7 - (bp & 7));
+        interleave(blk);
+        for (bp = 0; bp < 32; bp++)
+            coded[i + bp] = (blk[bp >> 3] >> (7 - (bp & 7))) & 1;
+    }
+
+    framer_sink_mrfsk::sptr fs = framer_sink_mrfsk::make(q);
+    for (it = 0; it < iterations; it++)
+        append_bits(stream, bits);
+    report("framer_sink_mrfsk", frame_len, run_sink(fs.get(), stream, q), (double)frame_len * iterations);
+
+    stream.clear();
+    framer_sink_mrfsk_nrnsc::sptr fsn = framer_sink_mrfsk_nrnsc::make(q);
+    for (it = 0; it < iterations; it++)
+        append_bits(stream, coded);
+    report("framer_sink_mrfsk_nrnsc", frame_len, run_sink(fsn.get(), stream, q), (double)frame_len * iterations);
+
+    /* demod output at symbol instants: preamble, SFD, coded frame */
+    std::vector<float> soft_stream;
+    const uint8_t shr[] = { 0x55, 0x55, 0x55, 0x55, 0x6f, 0x4e };
+    mrfsk_soft_deframer::sptr sd = mrfsk_soft_deframer::make(q, 12, 1);
+    for (it = 0; it < iterations; it++) {
+        for (i = 0; i < 64; i++)
+            soft_stream.push_back(i & 1 ? 0.1f : -0.1f);    // idle between frames
+        for (i = 0; i < (int)sizeof(shr) * 8; i++)
+            soft_stream.push_back((shr[i >> 3] >> (7 - (i & 7))) & 1 ? 0.1f : -0.1f);
+        for (i = 0; i < (int)coded.size(); i++)
+            soft_stream.push_back((coded[i] ? 0.1f : -0.1f) + 0.04f * ((rand() & 0xff) - 128) / 128);
+    }
+    report("mrfsk_soft_deframer nrnsc", frame_len, run_sink(sd.get(), soft_stream, q), (double)frame_len * iterations);
+}
+
+/* quadrature demod output of 4 octet preamble plus frame, per symbol: ramp then hold */
+static void
+bench_preamble_detector(int frame_len, int iterations, int sps)
+{
+    preamble_detector::sptr pd = preamble_detector::make(sps);
+    std::vector<float> wave(pd->history() - 1, 0);
+    std::vector<float> out(WORK_CHUNK);
+    gr_vector_const_void_star input_items(1);
+    gr_vector_void_star output_items(1);
+    int it, i, s;
+    float prev = 0;
+    size_t pos;
+    double t;
+
+    for (it = 0; it < iterations; it++) {
+        for (i = 0; i < (4 + frame_len) * 8; i++) {
+            float v = (i < 32 ? (i & 1) : (rand() & 1)) ? 0.1 : -0.1;
+            for (s = 0; s < sps; s++) {
+                prev += (v - prev) * 0.5;
+                wave.push_back(prev);
+            }
+        }
+    }
+
+    output_items[0] = &out[0];
+    t = now();
+    for (pos = 0; pos + (WORK_CHUNK * sps) + pd->history() - 1 <= wave.size(); pos += WORK_CHUNK * sps) {
+        input_items[0] = &wave[pos];
+        pd->work(WORK_CHUNK, input_items, output_items);
+    }
+    t = now() - t;
+    /* octets equivalent of symbols produced */
+    report("preamble_detector", frame_len, t, (double)(pos / sps) / 8);
+
+    /* its per window scan alone, crossings against a fixed mid */
+    int nwin = (wave.size() - 1) / (2 * sps);
+    std::vector<preamble_window_t> windows(nwin);
+    unsigned int acc = 0;
+    int zcu_at, zcd_at;
+    t = now();
+    preamble_windows(&windows[0], &wave[1], 2 * sps, nwin);
+    for (i = 0; i < nwin; i++) {
+        preamble_crossings(&wave[1 + i * 2 * sps], 2 * sps, 0, 0, &zcu_at, &zcd_at);
+        acc += windows[i].min_at + windows[i].max_at + zcu_at + zcd_at;
+    }
+    report("preamble_windows", frame_len, now() - t, (double)nwin / 4);
+    sink_val = acc;
+}
+
+/* unit variance Gaussian, Box-Muller */
+static float
+gaussian()
+{
+    float u = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+    float v = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+    return sqrtf(-2 * logf(u)) * cosf(2 * M_PI * v);
+}
+
+/*
+ * Detection probability of preamble_detector with the given thresholds,
+ * against preamble length. Frames of 1 to 8 octets of preamble, SFD, PHR
+ * and 16 octets of payload are GFSK modulated and quad demodulated to
+ * +-0.1 at full deviation, plus Gaussian noise; squelched (zeros) in
+ * between, and a random number of samples ahead so frames start anywhere
+ * in a window. A frame is detected when the detector locks before its SFD,
+ * then SFD and PHR slice intact.
+ */
+static void
+bench_detection(FILE *fp, int frames, int sps, float noise, const int thr[3], float freq_tol)
+{
+    const int payload_len = 16;
+    mrfsk_modulator mod(sps, 1.0, 0.5);
+    float gain = 0.1f * sps / M_PI;
+    int pre, f, i;
+
+    fprintf(fp, "{\n  \"frames\": %d,\n  \"samples_per_symbol\": %d,\n  \"noise\": %.4f,\n"
+        "  \"thresholds\": [ %d, %d, %d, %.3f ],\n  \"detection\": [\n",
+        frames, sps, noise, thr[0], thr[1], thr[2], freq_tol);
+    for (pre = 1; pre <= 8; pre++) {
+        preamble_detector::sptr pd = preamble_detector::make(sps, thr[0], thr[1], thr[2], freq_tol);
+        std::vector<uint8_t> ota(pre + 4 + payload_len + 4);
+        std::vector<uint8_t> payload(payload_len);
+        std::vector<gr_complex> x;
+        std::vector<float> wave, out;
+        gr_vector_const_void_star input_items(1);
+        gr_vector_void_star output_items(1);
+        int detected = 0;
+
+        for (f = 0; f < frames; f++) {
+            int lead = rand() % (2 * sps) + 16 * sps;
+            int len, pre_end, end, sfd_at, n;
+            uint64_t locks = pd->locks();
+
+            for (i = 0; i < payload_len; i++)
+                payload[i] = rand();
+            len = mrfsk_encode_frame(&ota[0], ota.size(), pre, 0, 1, 0, &payload[0], payload_len);
+            x.resize(len * 8 * sps);
+            mod.modulate(&ota[0], len, &x[0], 1.0);
+
+            /* history and lead-in, frame, then whole windows of squelch */
+            wave.assign(pd->history() + lead, 0);
+            for (i = 1; i < (int)x.size(); i++)
+                wave.push_back(gain * std::arg(x[i] * std::conj(x[i-1])) + noise * gaussian());
+            end = lead + x.size();
+            end += 4 * sps - end % (2 * sps);
+            wave.resize(pd->history() - 1 + end, 0);
+
+            /* up to the last window before SFD, then the rest */
+            pre_end = (lead + pre * 8 * sps) / (2 * sps) * 2;
+            out.resize(end / sps);
+            input_items[0] = &wave[0];
+            output_items[0] = &out[0];
+            pd->work(pre_end, input_items, output_items);
+            if (pd->locks() == locks)
+                continue;
+            input_items[0] = &wave[pre_end * sps];
+            output_items[0] = &out[pre_end];
+            pd->work(end / sps - pre_end, input_items, output_items);
+
+            /* SFD and PHR, within a few symbols of where they were sent */
+            sfd_at = (lead + pre * 8 * sps) / sps;
+            for (n = sfd_at - 4; n <= sfd_at + 4; n++) {
+                for (i = 0; i < 32; i++) {
+                    int bit = (ota[pre + i / 8] >> (7 - i % 8)) & 1;
+                    if ((out[n + i] > 0) != bit)
+                        break;
+                }
+                if (i == 32) {
+                    detected++;
+                    break;
+                }
+            }
+        }
+        fprintf(fp, "    { \"preamble_octets\": %d, \"p_detect\": %.4f, \"false_locks_per_frame\": %.4f }%s\n",
+            pre, (double)detected / frames, (double)pd->false_locks() / frames, pre < 8 ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    std::vector<int> frame_lens;
+    int iterations = 1000;
+    int sps = 8;
+    bool detection = false;
+    float noise = 0.01f;
+    int thr[3] = { 3, 6, 4 };
+    float freq_tol = 0.1f;
+    FILE *fp = stdout;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            sps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-p") == 0)
+            detection = true;
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            noise = atof(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d,%d,%d,%f", &thr[0], &thr[1], &thr[2], &freq_tol) != 4) {
+                fprintf(stderr, "-t %s: must be avg,lock,drift,tol\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            fp = fopen(argv[++i], "w");
+            if (fp == NULL) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else {
+            int len = atoi(argv[i]);
+            if (len < 5 || len > aMaxPHYPacketSize) {
+                fprintf(stderr, "frame_len %s: must be 5 to %d\n", argv[i], aMaxPHYPacketSize);
+                return 1;
+            }
+            frame_lens.push_back(len);
+        }
+    }
+    if (frame_lens.empty()) {
+        frame_lens.push_back(16);
+        frame_lens.push_back(127);
+        frame_lens.push_back(aMaxPHYPacketSize);
+    }
+
+    srand(1);
+    if (detection) {
+        try {
+            bench_detection(fp, iterations, sps, noise, thr, freq_tol);
+        } catch (std::out_of_range &e) {
+            fprintf(stderr, "-t: %s\n", e.what());
+            return 1;
+        }
+        if (fp != stdout)
+            fclose(fp);
+        return 0;
+    }
+
+    for (i = 0; i < (int)frame_lens.size(); i++) {
+        bench_kernels(frame_lens[i], iterations);
+        bench_source(frame_lens[i], iterations);
+        bench_mod(frame_lens[i], iterations, sps);
+        bench_framers(frame_lens[i], iterations);
+        bench_preamble_detector(frame_lens[i], iterations, sps);
+    }
+
+    fprintf(fp, "{\n  \"iterations\": %d,\n  \"samples_per_symbol\": %d,\n  \"results\": [\n", iterations, sps);
+    for (i = 0; i < (int)results.size(); i++) {
+        fprintf(fp, "    { \"name\": \"%s\", \"frame_len\": %d, \"ns_per_byte\": %.4f, \"mbit_per_s\": %.3f }%s\n",
+            results[i].name.c_str(), results[i].frame_len, results[i].ns_per_byte, results[i].mbps,
+            i + 1 < (int)results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    if (fp != stdout)
+        fclose(fp);
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "block_stats.h"
+
+namespace gr {
+  namespace ieee802154g {
+
+    block_stats::block_stats()
+      : d_interval(boost::posix_time::seconds(0))
+    {
+    }
+
+    block_stats::~block_stats()
+    {
+    }
+
+    void
+    block_stats::set_interval(double seconds)
+    {
+        d_interval = boost::posix_time::microseconds((int64_t)(seconds * 1e6));
+        d_next = boost::posix_time::ptime();    // from next poll()
+    }
+
+    void
+    block_stats::poll(gr::basic_block *owner)
+    {
+        if (d_interval <= boost::posix_time::time_duration())
+            return;
+        boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+        if (d_next.is_not_a_date_time()) {
+            d_next = now + d_interval;
+        } else if (now >= d_next) {
+            d_next = now + d_interval;
+            owner->message_port_pub(pmt::mp("stats"),
+                    pmt::dict_add(to_pmt(), pmt::mp("block"), pmt::mp(owner->alias())));
+        }
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
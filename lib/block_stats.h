@@ -0,0 +1,80 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_BLOCK_STATS_H
+#define INCLUDED_IEEE802154G_BLOCK_STATS_H
+
+#include <gnuradio/block.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#ifdef GR_CTRLPORT
+#include <gnuradio/rpcregisterhelpers.h>
+#endif
+
+namespace gr {
+  namespace ieee802154g {
+
+    /*
+     * Counters of a block, kept by a derived class as relaxed atomics so
+     * any thread may read them. poll() from work() sends to_pmt() as a dict
+     * on the owner's "stats" port every interval, with the owner's alias
+     * under "block".
+     */
+    class block_stats
+    {
+     public:
+        block_stats();
+        virtual ~block_stats();
+
+        virtual pmt::pmt_t to_pmt() const = 0;
+
+        /* 0 never, the default; call both under the owner's d_setlock */
+        void set_interval(double seconds);
+        void poll(gr::basic_block *owner);
+
+     private:
+        boost::posix_time::time_duration d_interval;
+        boost::posix_time::ptime d_next;
+    };
+
+#ifdef GR_CTRLPORT
+    template <class T>
+    struct block_stats_var
+    {
+        const char *name;
+        uint64_t (T::*get)() const;
+        const char *desc;
+    };
+
+    /* counters as ControlPort variables of a block with their getters */
+    template <class T, size_t N>
+    void block_stats_rpc(T *block, const block_stats_var<T> (&vars)[N])
+    {
+        for (size_t i = 0; i < N; i++)
+            block->add_rpc_variable(rpcbasic_sptr(new rpcbasic_register_get<T, uint64_t>(
+                    block->alias(), vars[i].name, vars[i].get,
+                    pmt::from_uint64(0), pmt::from_uint64(1000000), pmt::from_uint64(0),
+                    "", vars[i].desc, RPC_PRIVLVL_MIN, DISPTIME | DISPOPTSTRIP)));
+    }
+#endif /* GR_CTRLPORT */
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_BLOCK_STATS_H */
@@ -22,7 +22,7 @@
 #define INCLUDED_IEEE802154G_FRAMER_SINK_MRFSK_IMPL_H
 
 #include <ieee802154g/framer_sink_mrfsk.h>
-#include "utils_mrfsk.h"
+#include "mrfsk_decoder.h"
 
 namespace gr {
   namespace ieee802154g {
@@ -30,24 +30,31 @@ namespace gr {
     class framer_sink_mrfsk_impl : public framer_sink_mrfsk
     {
      private:
-        enum state_t { STATE_SYNC_SEARCH, STATE_HAVE_SYNC, STATE_HAVE_HEADER };
-        static const int HEADERBITLEN   = 16;   // PHR size in bits
-        state_t     d_state;
-        msg_queue::sptr     d_target_queue;     // where to send received packet
-        MRFSK_PHR_t phr;
-        int d_headerbitlen_cnt;
-        unsigned char d_packet_byte_index, d_packet_byte;
-        uint16_t d_packetlen_cnt;
-        uint8_t d_packet[aMaxPHYPacketSize];    // PSDU buffer
-        uint32_t crc_32;
-        uint16_t crc16_;
-        uint32_t dbg_hist;
-        uint16_t lfsr;
+        mrfsk_rx_stats d_stats;         // ahead of the decoders using it
+        mrfsk_uncoded_decoder d_dec;
+        bool d_packed;          // 8 bits per input item, SFD from stream tags
+        pmt::pmt_t d_sync_key;
+        mrfsk_packed_sfd d_sfd;
 
      public:
-      framer_sink_mrfsk_impl(msg_queue::sptr target_queue);
+      framer_sink_mrfsk_impl(msg_queue::sptr target_queue, const std::string &sync_tag);
       ~framer_sink_mrfsk_impl();
 
+      void set_lossy(bool lossy);
+      uint64_t dropped() const { return d_stats.dropped; }
+      void set_max_frame_length(int max_frame_length);
+      void set_preempt(bool preempt);
+      uint64_t sfd_uncoded() const { return d_stats.sfd_uncoded; }
+      uint64_t sfd_nrnsc() const { return d_stats.sfd_nrnsc; }
+      uint64_t phr_rejects() const { return d_stats.phr_rejects; }
+      uint64_t crc16_ok() const { return d_stats.crc16_ok; }
+      uint64_t crc16_fail() const { return d_stats.crc16_fail; }
+      uint64_t crc32_ok() const { return d_stats.crc32_ok; }
+      uint64_t crc32_fail() const { return d_stats.crc32_fail; }
+      uint64_t octets() const { return d_stats.octets; }
+      void set_stats_interval(double seconds);
+      void setup_rpc();
+
       // Where all the action really happens
       int work(int noutput_items,
 	       gr_vector_const_void_star &input_items,
@@ -58,4 +65,3 @@ namespace gr {
 } // namespace gr
 
 #endif /* INCLUDED_IEEE802154G_FRAMER_SINK_MRFSK_IMPL_H */
-
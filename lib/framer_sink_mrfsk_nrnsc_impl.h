@@ -22,9 +22,7 @@
 #define INCLUDED_IEEE802154G_FRAMER_SINK_MRFSK_NRNSC_IMPL_H
 
 #include <ieee802154g/framer_sink_mrfsk_nrnsc.h>
-#include "utils_mrfsk.h"
-
-#define NUM_WEIGHTS     4
+#include "mrfsk_decoder.h"
 
 namespace gr {
   namespace ieee802154g {
@@ -32,30 +30,31 @@ namespace gr {
     class framer_sink_mrfsk_nrnsc_impl : public framer_sink_mrfsk_nrnsc
     {
      private:
-        enum state_t { STATE_SYNC_SEARCH, STATE_HAVE_SYNC, STATE_HAVE_HEADER };
-        state_t     d_state;
-        msg_queue::sptr     d_target_queue;     // where to send received packet
-        uint32_t rf_buf;
-        char rf_buf_bitlen_cnt;
-        uint32_t dbg_hist;
-        uint8_t ppui, pui;
-        void decode_ui(uint8_t);
-        int weights[NUM_WEIGHTS];
-        void shift_weights(void);
-        void push_bit(void);
-        uint8_t phr_psdu_buf[2050];
-        uint16_t phr_psdu_buf_idx;
-        int phr_psdu_buf_idx_stop;
-        uint8_t db_bp;
-        MRFSK_PHR_t phr;
-        uint16_t crc16;
-        uint32_t crc_32;
-        uint16_t lfsr;
+        mrfsk_rx_stats d_stats;         // ahead of the decoders using it
+        mrfsk_nrnsc_decoder d_dec;
+        bool d_packed;          // 8 bits per input item, SFD from stream tags
+        pmt::pmt_t d_sync_key;
+        mrfsk_packed_sfd d_sfd;
 
      public:
-      framer_sink_mrfsk_nrnsc_impl(msg_queue::sptr target_queue);
+      framer_sink_mrfsk_nrnsc_impl(msg_queue::sptr target_queue, const std::string &sync_tag);
       ~framer_sink_mrfsk_nrnsc_impl();
 
+      void set_lossy(bool lossy);
+      uint64_t dropped() const { return d_stats.dropped; }
+      void set_max_frame_length(int max_frame_length);
+      void set_preempt(bool preempt);
+      uint64_t sfd_uncoded() const { return d_stats.sfd_uncoded; }
+      uint64_t sfd_nrnsc() const { return d_stats.sfd_nrnsc; }
+      uint64_t phr_rejects() const { return d_stats.phr_rejects; }
+      uint64_t crc16_ok() const { return d_stats.crc16_ok; }
+      uint64_t crc16_fail() const { return d_stats.crc16_fail; }
+      uint64_t crc32_ok() const { return d_stats.crc32_ok; }
+      uint64_t crc32_fail() const { return d_stats.crc32_fail; }
+      uint64_t octets() const { return d_stats.octets; }
+      void set_stats_interval(double seconds);
+      void setup_rpc();
+
       // Where all the action really happens
       int work(int noutput_items,
 	       gr_vector_const_void_star &input_items,
@@ -66,4 +65,3 @@ namespace gr {
 } // namespace gr
 
 #endif /* INCLUDED_IEEE802154G_FRAMER_SINK_MRFSK_NRNSC_IMPL_H */
-
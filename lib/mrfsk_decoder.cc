@@ -0,0 +1,563 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mrfsk_decoder.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+
+namespace gr {
+  namespace ieee802154g {
+
+    mrfsk_rx_stats::mrfsk_rx_stats()
+      : sfd_uncoded(0), sfd_nrnsc(0), phr_rejects(0),
+        crc16_ok(0), crc16_fail(0), crc32_ok(0), crc32_fail(0),
+        octets(0), dropped(0)
+    {
+    }
+
+    pmt::pmt_t
+    mrfsk_rx_stats::to_pmt() const
+    {
+        pmt::pmt_t d = pmt::make_dict();
+        d = pmt::dict_add(d, pmt::mp("sfd_uncoded"), pmt::from_uint64(sfd_uncoded));
+        d = pmt::dict_add(d, pmt::mp("sfd_nrnsc"), pmt::from_uint64(sfd_nrnsc));
+        d = pmt::dict_add(d, pmt::mp("phr_rejects"), pmt::from_uint64(phr_rejects));
+        d = pmt::dict_add(d, pmt::mp("crc16_ok"), pmt::from_uint64(crc16_ok));
+        d = pmt::dict_add(d, pmt::mp("crc16_fail"), pmt::from_uint64(crc16_fail));
+        d = pmt::dict_add(d, pmt::mp("crc32_ok"), pmt::from_uint64(crc32_ok));
+        d = pmt::dict_add(d, pmt::mp("crc32_fail"), pmt::from_uint64(crc32_fail));
+        d = pmt::dict_add(d, pmt::mp("octets"), pmt::from_uint64(octets));
+        d = pmt::dict_add(d, pmt::mp("dropped"), pmt::from_uint64(dropped));
+        return d;
+    }
+
+    mrfsk_decoder::mrfsk_decoder(msg_queue::sptr target_queue, gr::basic_block *owner,
+            mrfsk_rx_stats &stats)
+      : d_target_queue(target_queue),
+        d_owner(owner),
+        d_stats(stats),
+        d_lossy(false),
+        d_max_length(aMaxPHYPacketSize),
+        d_preempt(false),
+        d_active(false)
+    {
+    }
+
+    mrfsk_decoder::~mrfsk_decoder()
+    {
+    }
+
+    /* PHR is in: message sized to the PSDU, which is decoded straight into it */
+    bool
+    mrfsk_decoder::start_frame(long type)
+    {
+        /* not something this receiver sent: most likely a false sync */
+        if (phr.bits.MS || phr.bits.reserved ||
+                phr.bits.frame_length > d_max_length.load(boost::memory_order_relaxed) ||
+                phr.bits.frame_length < (phr.bits.FCS ? 2 : 4)) {
+            mrfsk_rx_stats::bump(d_stats.phr_rejects);
+            d_active = false;
+            return false;
+        }
+        d_type = type;
+        if (d_target_queue) {
+            d_msg = message::make(type, phr.word, 0, phr.bits.frame_length);
+            d_psdu = d_msg->msg();
+        } else {
+            d_buf.resize(phr.bits.frame_length);
+            d_psdu = &d_buf[0];
+        }
+        return true;
+    }
+
+    /* whole PSDU is in: dewhiten, check FCS, send */
+    void
+    mrfsk_decoder::end_frame()
+    {
+        int len = phr.bits.frame_length;
+        char crc_ok = 0;
+        uint16_t lfsr, crc16;
+
+        if (phr.bits.DW) {
+            lfsr = PN9_SEED;
+            pn9_xor(d_psdu, len, &lfsr);
+        }
+        if (phr.bits.FCS) {
+            /* CRC over entire PSDU including FCS: zero when good */
+            crc16 = crc_msb_first(INITIAL_CRC16, d_psdu, len);
+            crc_ok = crc16 == 0;
+            mrfsk_rx_stats::bump(crc_ok ? d_stats.crc16_ok : d_stats.crc16_fail);
+        } else {
+            int zs = len - 4;
+            uint8_t z = 0;
+            uint32_t crc_32, rx_crc;
+            crc_32 = digital_update_crc32(INITIAL_CRC32, d_psdu, zs > 0 ? zs : 0);
+            // run crc32 over zeros if less that 4 bytes usable payload
+            while (zs < 4) {
+                crc_32 = digital_update_crc32(crc_32, &z, 1);
+                zs++;
+            }
+            crc_32 = ~crc_32;
+            rx_crc = d_psdu[len-4] << 24;
+            rx_crc += d_psdu[len-3] << 16;
+            rx_crc += d_psdu[len-2] << 8;
+            rx_crc += d_psdu[len-1];
+            crc_ok = rx_crc == crc_32;
+            mrfsk_rx_stats::bump(crc_ok ? d_stats.crc32_ok : d_stats.crc32_fail);
+        }
+        /* PDU: PSDU without FCS, settings in the same keys mrfsk_source takes */
+        int fcs_len = phr.bits.FCS ? 2 : 4;
+        pmt::pmt_t meta = pmt::make_dict();
+        meta = pmt::dict_add(meta, pmt::mp("phr"), pmt::from_long(phr.word));
+        meta = pmt::dict_add(meta, pmt::mp("fec_en"), pmt::from_bool(d_type != 0));
+        meta = pmt::dict_add(meta, pmt::mp("dw"), pmt::from_bool(phr.bits.DW));
+        meta = pmt::dict_add(meta, pmt::mp("crc_type_16"), pmt::from_bool(phr.bits.FCS));
+        meta = pmt::dict_add(meta, pmt::mp("crc_ok"), pmt::from_bool(crc_ok));
+        meta = pmt::dict_add(meta, pmt::mp("length"), pmt::from_long(len));
+        d_owner->message_port_pub(pmt::mp("pdus"),
+                pmt::cons(meta, pmt::init_u8vector(len - fcs_len, d_psdu)));
+        mrfsk_rx_stats::bump(d_stats.octets, len - fcs_len);
+
+        if (d_target_queue) {
+            d_msg->set_arg2(crc_ok);
+            if (d_lossy.load(boost::memory_order_relaxed) && d_target_queue->full_p())
+                mrfsk_rx_stats::bump(d_stats.dropped);  // never wait on a slow reader
+            else
+                d_target_queue->insert_tail(d_msg);     // send it
+            d_msg.reset();  // receiver owns it now
+        }
+        d_active = false;
+    }
+
+    void
+    mrfsk_decoder::push_flagged(const uint8_t *in, int n)
+    {
+        int count = 0;
+        bool preempt = this->preempt();
+
+        while (count < n) {
+            if (!d_active) {
+                /* get SFD: */
+                while (count < n && !(in[count] & 0x2))   // correlator flag set?
+                    count++;
+                if (count == n)
+                    break;
+                start();
+                push_bit(in[count++] & 1);
+            }
+            while (count < n && d_active) {
+                if (preempt && (in[count] & 0x2))
+                    start();
+                push_bit(in[count++] & 1);
+            }
+        }
+    }
+
+    mrfsk_uncoded_decoder::mrfsk_uncoded_decoder(msg_queue::sptr target_queue, gr::basic_block *owner,
+            mrfsk_rx_stats &stats)
+      : mrfsk_decoder(target_queue, owner, stats)
+    {
+    }
+
+    void
+    mrfsk_uncoded_decoder::start()
+    {
+        mrfsk_rx_stats::bump(d_stats.sfd_uncoded);
+        d_active = true;
+        phr.word = 0;
+        d_headerbitlen_cnt = 0;
+    }
+
+    void
+    mrfsk_uncoded_decoder::push_bit(int bit)
+    {
+        if (d_headerbitlen_cnt < PHR_LENGTH * 8) {     // get PHR:
+            phr.word = (phr.word << 1) | bit;
+            if (++d_headerbitlen_cnt == PHR_LENGTH * 8 && start_frame(0)) {
+                d_packet_byte_index = 0;
+                d_packet_byte = 0;
+                d_packetlen_cnt = 0;
+            }
+            return;
+        }
+
+        d_packet_byte = (d_packet_byte << 1) | bit;
+        if (d_packet_byte_index++ == 7) {
+            d_psdu[d_packetlen_cnt++] = d_packet_byte;
+            d_packet_byte_index = 0;
+            if (d_packetlen_cnt >= phr.bits.frame_length)
+                end_frame();
+        }
+    }
+
+    int
+    mrfsk_uncoded_decoder::push_octets(const uint8_t *in, int n)
+    {
+        int i = 0, m;
+
+        while (i < n && d_headerbitlen_cnt < PHR_LENGTH * 8) {   // get PHR:
+            phr.word = (phr.word << 8) | in[i++];
+            d_headerbitlen_cnt += 8;
+            if (d_headerbitlen_cnt == PHR_LENGTH * 8) {
+                if (!start_frame(0))
+                    return i;
+                d_packetlen_cnt = 0;
+            }
+        }
+        if (d_headerbitlen_cnt < PHR_LENGTH * 8)
+            return i;
+
+        m = std::min<int>(phr.bits.frame_length - d_packetlen_cnt, n - i);
+        memcpy(d_psdu + d_packetlen_cnt, in + i, m);
+        d_packetlen_cnt += m;
+        if (d_packetlen_cnt >= phr.bits.frame_length)
+            end_frame();
+        return i + m;
+    }
+
+    mrfsk_nrnsc_decoder::mrfsk_nrnsc_decoder(msg_queue::sptr target_queue, gr::basic_block *owner,
+            mrfsk_rx_stats &stats)
+      : mrfsk_decoder(target_queue, owner, stats)
+    {
+    }
+
+    void
+    mrfsk_nrnsc_decoder::start()
+    {
+        int n;
+
+        mrfsk_rx_stats::bump(d_stats.sfd_nrnsc);
+        d_active = true;
+        rf_buf = 0;
+        rf_buf_bitlen_cnt = 0;
+        for (n = NUM_WEIGHTS-1; n >= 0; n--)
+            weights[n] = 0;
+        phr_psdu_buf_idx = 0;
+        db_bp = 0x80;
+        phr_psdu_buf_idx_stop = -1;
+    }
+
+    void
+    mrfsk_nrnsc_decoder::push_bit(int bit)
+    {
+        rf_buf = (rf_buf << 1) | bit;
+        if (++rf_buf_bitlen_cnt == 32) {
+            rf_buf_bitlen_cnt = 0;
+            decode_block();
+        }
+    }
+
+    int
+    mrfsk_nrnsc_decoder::push_octets(const uint8_t *in, int n)
+    {
+        int i = 0;
+
+        /* interleaved sections gathered four octets at a time */
+        while (i < n && d_active) {
+            rf_buf = (rf_buf << 8) | in[i++];
+            rf_buf_bitlen_cnt += 8;
+            if (rf_buf_bitlen_cnt == 32) {
+                rf_buf_bitlen_cnt = 0;
+                decode_block();
+            }
+        }
+        return i;
+    }
+
+    /* one interleaved 32-bit section in rf_buf: deinterleave and decode */
+    void
+    mrfsk_nrnsc_decoder::decode_block()
+    {
+        int s;
+        interleave_u32(&rf_buf);
+        if (phr_psdu_buf_idx == 0) { // first time:
+            ppui = rf_buf >> 30;
+            pui = (rf_buf >> 28) & 3;
+            s = 26;
+            decode_ui((rf_buf >> s) & 3);
+            shift_weights();
+            s -= 2;
+            for (; s >= 0; s -= 2) {
+                decode_ui((rf_buf >> s) & 3);
+                push_decoded_bit();
+                shift_weights();
+            }
+        } else {
+            for (s = 30; s >= 0; s -= 2) {
+                decode_ui((rf_buf >> s) & 3);
+                push_decoded_bit();
+                shift_weights();
+                if (phr_psdu_buf_idx_stop == -1) {
+                    if (phr_psdu_buf_idx == PHR_LENGTH) {
+                        phr.word = phr_buf[0] << 8;
+                        phr.word |= phr_buf[1];
+                        if (!start_frame(1))
+                            break;
+                        phr_psdu_buf_idx_stop = phr.bits.frame_length + PHR_LENGTH;
+                    }
+                } else if (phr_psdu_buf_idx >= phr_psdu_buf_idx_stop) {
+                    end_frame();
+                    break;
+                }
+            }
+        }
+    }
+
+    void
+    mrfsk_nrnsc_decoder::decode_ui(uint8_t ui)
+    {
+        bool w3;
+
+        ui &= 3;
+        if (ui & 2) {
+            if ( (pui >> 1) ^ (pui & 1) )
+                w3 = !(ppui >> 1) ^ (ppui & 1);
+            else
+                w3 = (ppui >> 1) ^ (ppui & 1);
+        } else {
+            if ( (pui >> 1) ^ (pui & 1) )
+                w3 = (ppui >> 1) ^ (ppui & 1);
+            else
+                w3 = !(ppui >> 1) ^ (ppui & 1);
+        }
+        if (w3)
+            weights[3]++;
+        else
+            weights[3]--;
+
+        if ( (ui >> 1) ^ (ui & 1) )
+            weights[2]++;
+        else
+            weights[2]--;
+
+        if ( (pui >> 1) ^ (pui & 1) )
+            weights[1]++;
+        else
+            weights[1]--;
+
+        if ( (ppui >> 1) ^ (ppui & 1) )
+            weights[0]++;
+        else
+            weights[0]--;
+
+        ppui = pui;
+        pui = ui;
+        
+    }
+
+    void
+    mrfsk_nrnsc_decoder::shift_weights()
+    {
+        weights[0] = weights[1];
+        weights[1] = weights[2];
+        weights[2] = weights[3];
+        weights[3] = 0;
+    }
+
+    /* PHR octets go to phr_buf, the rest to the message allocated once
+     * frame_length is known; work() stops before running past it. */
+    void
+    mrfsk_nrnsc_decoder::push_decoded_bit(void)
+    {
+        uint8_t *p;
+
+        if (phr_psdu_buf_idx < PHR_LENGTH)
+            p = &phr_buf[phr_psdu_buf_idx];
+        else
+            p = &d_psdu[phr_psdu_buf_idx - PHR_LENGTH];
+
+        if (weights[0] > 0)
+            *p |= db_bp;
+        else
+            *p &= ~db_bp;
+
+        db_bp >>= 1;
+        if (db_bp == 0x00) {
+            db_bp = 0x80;
+            phr_psdu_buf_idx++;
+        }
+    }
+
+    mrfsk_soft_nrnsc_decoder::mrfsk_soft_nrnsc_decoder(msg_queue::sptr target_queue, gr::basic_block *owner,
+            mrfsk_rx_stats &stats)
+      : mrfsk_decoder(target_queue, owner, stats),
+        d_decisions(8 * (PHR_LENGTH + aMaxPHYPacketSize + 2)),
+        d_bits(PHR_LENGTH + aMaxPHYPacketSize + 2)
+    {
+    }
+
+    void
+    mrfsk_soft_nrnsc_decoder::start()
+    {
+        mrfsk_rx_stats::bump(d_stats.sfd_nrnsc);
+        d_active = true;
+        d_nsym = 0;
+        d_steps = 0;
+        d_steps_stop = 0;
+        nrnsc_viterbi_init(d_metric, NRNSC_STATE_INIT);
+    }
+
+    void
+    mrfsk_soft_nrnsc_decoder::push_bit(int bit)
+    {
+        push_soft(bit ? 127 : -127);
+    }
+
+    int
+    mrfsk_soft_nrnsc_decoder::push_octets(const uint8_t *in, int n)
+    {
+        int i, bp;
+
+        for (i = 0; i < n && d_active; i++) {
+            for (bp = 0x80; bp != 0; bp >>= 1)
+                push_soft((in[i] & bp) ? 127 : -127);
+        }
+        return i;
+    }
+
+    void
+    mrfsk_soft_nrnsc_decoder::push_soft(int8_t soft)
+    {
+        d_block[d_nsym++] = soft;
+        if (d_nsym < 32)
+            return;
+        d_nsym = 0;
+        deinterleave_soft(d_soft, d_block);
+        nrnsc_viterbi_acs(d_metric, &d_decisions[d_steps], d_soft, 16);
+        d_steps += 16;
+
+        if (d_steps_stop == 0 && d_steps == 48) {
+            size_t n;
+
+            nrnsc_viterbi_traceback(&d_bits[0], &d_decisions[0], d_steps,
+                    nrnsc_viterbi_best(d_metric));
+            phr.word = (d_bits[0] << 8) | d_bits[1];
+            if (!start_frame(1))
+                return;
+            /* PHR, PSDU, then tail and pad to a whole block */
+            n = PHR_LENGTH + phr.bits.frame_length;
+            d_steps_stop = 8 * (n + ((n & 1) ? 1 : 2));
+        }
+        if (d_steps == d_steps_stop) {
+            nrnsc_viterbi_traceback(&d_bits[0], &d_decisions[0], d_steps, NRNSC_STATE_END);
+            memcpy(d_psdu, &d_bits[PHR_LENGTH], phr.bits.frame_length);
+            end_frame();
+        }
+    }
+
+    mrfsk_dual_sfd::mrfsk_dual_sfd(int preamble_bits, int threshold_uncoded, int threshold_nrnsc)
+    {
+        uint64_t preamble;
+
+        if (preamble_bits < 0 || preamble_bits > 48)
+            throw std::out_of_range("preamble_bits must be 0..48");
+
+        /* preamble is 0x55 octets, so the bit just before SFD is a one */
+        preamble = 0x5555555555555555ULL & ((1ULL << preamble_bits) - 1);
+        d_code_uncoded = (preamble << 16) | 0x904e;
+        d_code_nrnsc = (preamble << 16) | 0x6f4e;
+        d_mask = (1ULL << (16 + preamble_bits)) - 1;
+        d_threshold_uncoded = threshold_uncoded;
+        d_threshold_nrnsc = threshold_nrnsc;
+    }
+
+    mrfsk_packed_sfd::mrfsk_packed_sfd()
+      : d_shift(0),
+        d_prev(0),
+        d_tail_bits(0)
+    {
+    }
+
+    int
+    mrfsk_packed_sfd::sync_bit(const tag_t &tag) const
+    {
+        return pmt::is_integer(tag.value) ? pmt::to_long(tag.value) & 7 : 0;
+    }
+
+    void
+    mrfsk_packed_sfd::work(mrfsk_decoder &dec, const uint8_t *in, int n, uint64_t nr,
+            const std::vector<tag_t> &tags)
+    {
+        uint8_t buf[256];
+        uint64_t resume;
+        unsigned int t = 0;
+        int count = 0, stop, m, k;
+
+        while (count < n) {
+            if (!dec.active()) {
+                /* search resumes d_tail_bits into d_prev, or at in[count] */
+                resume = (nr + count) * 8 - (d_tail_bits ? 8 - d_tail_bits : 0);
+                while (t < tags.size() && tags[t].offset * 8 + sync_bit(tags[t]) < resume)
+                    t++;    // SFD inside a frame already being received
+                if (t == tags.size()) {
+                    d_tail_bits = 0;
+                    return;     // nothing else in this buffer
+                }
+                d_shift = sync_bit(tags[t]);
+                if (tags[t].offset >= nr + count) {
+                    count = tags[t].offset - nr;
+                    if (d_shift != 0)
+                        d_prev = in[count++];   // only its low bits are frame
+                }   // else SFD ends in d_prev, so d_shift is nonzero
+                t++;
+                d_tail_bits = 0;
+                dec.start();
+            }
+
+            /* with preempt, frame gets only whole octets before the next SFD */
+            stop = n;
+            if (dec.preempt()) {
+                uint64_t next = (nr + count) * 8 - (d_shift ? 8 - d_shift : 0);   // first unread bit
+                while (t < tags.size() && tags[t].offset * 8 + sync_bit(tags[t]) < next)
+                    t++;
+                if (t < tags.size()) {
+                    stop = std::min<uint64_t>(n, count + (tags[t].offset * 8 + sync_bit(tags[t]) - next) / 8);
+                    if (stop == count) {
+                        dec.abort();
+                        d_tail_bits = d_shift;
+                        continue;
+                    }
+                }
+            }
+
+            if (d_shift == 0) {
+                count += dec.push_octets(in + count, stop - count);
+            } else {
+                /* octet k starts d_shift bits into the item before in[count + k] */
+                m = std::min<int>(stop - count, sizeof(buf));
+                buf[0] = (d_prev << d_shift) | (in[count] >> (8 - d_shift));
+                for (k = 1; k < m; k++)
+                    buf[k] = (in[count + k - 1] << d_shift) | (in[count + k] >> (8 - d_shift));
+                count += dec.push_octets(buf, m);
+                d_prev = in[count - 1];
+            }
+            if (!dec.active())
+                d_tail_bits = d_shift;  // frame done, rest of d_prev unread
+        }
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
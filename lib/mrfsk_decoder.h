@@ -0,0 +1,265 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_IEEE802154G_MRFSK_DECODER_H
+#define INCLUDED_IEEE802154G_MRFSK_DECODER_H
+
+#include <gnuradio/block.h>
+#include <gnuradio/msg_queue.h>
+#include <gnuradio/tags.h>
+#include <boost/atomic.hpp>
+#include <vector>
+#include "block_stats.h"
+#include "utils_mrfsk.h"
+
+#define NUM_WEIGHTS     4
+
+namespace gr {
+  namespace ieee802154g {
+
+    /* counters of one receive block, shared by its decoders */
+    struct mrfsk_rx_stats : public block_stats
+    {
+        boost::atomic<uint64_t> sfd_uncoded, sfd_nrnsc, phr_rejects;
+        boost::atomic<uint64_t> crc16_ok, crc16_fail, crc32_ok, crc32_fail;
+        boost::atomic<uint64_t> octets;         // PSDU less FCS, every frame sent
+        boost::atomic<uint64_t> dropped;        // lossy target_queue full
+
+        mrfsk_rx_stats();
+        static void bump(boost::atomic<uint64_t> &c, uint64_t n = 1)
+        {
+            c.fetch_add(n, boost::memory_order_relaxed);
+        }
+        pmt::pmt_t to_pmt() const;
+    };
+
+#ifdef GR_CTRLPORT
+    /* the counters as ControlPort variables of a block with their getters */
+    template <class T>
+    void mrfsk_rx_stats_rpc(T *block)
+    {
+        static const block_stats_var<T> vars[] = {
+            { "sfd_uncoded", &T::sfd_uncoded, "SFDs found, uncoded" },
+            { "sfd_nrnsc", &T::sfd_nrnsc, "SFDs found, NRNSC" },
+            { "phr_rejects", &T::phr_rejects, "Frames dropped at PHR" },
+            { "crc16_ok", &T::crc16_ok, "Good FCS, CRC-16" },
+            { "crc16_fail", &T::crc16_fail, "Bad FCS, CRC-16" },
+            { "crc32_ok", &T::crc32_ok, "Good FCS, CRC-32" },
+            { "crc32_fail", &T::crc32_fail, "Bad FCS, CRC-32" },
+            { "octets", &T::octets, "PSDU octets delivered" },
+            { "dropped", &T::dropped, "Frames dropped, queue full" },
+        };
+
+        block_stats_rpc(block, vars);
+    }
+#endif /* GR_CTRLPORT */
+
+    /*
+     * Receive side of one frame, from the first bit after SFD: PHR, PSDU,
+     * dewhitening and FCS check. The frame goes to target_queue, if any, as
+     * a message of type 0 (uncoded) or 1 (NRNSC), arg1 PHR, arg2 1 for good
+     * FCS, with the PSDU decoded straight into it; and as a PDU on the
+     * owner's "pdus" message port. Bits come one at a time, or as octets
+     * already aligned to the SFD; active() is false again once the frame is
+     * sent or dropped. A PHR with MS or reserved bits set, or a length
+     * beyond the maximum or too short for its FCS, drops the frame at once.
+     * What happened to each frame is counted in the owner's stats.
+     *
+     * end_frame() waits on a full target_queue unless lossy, so the owner
+     * must not hold d_setlock while decoding. The settings are atomics
+     * instead, which setters change from any thread, even while work()
+     * waits on the queue.
+     */
+    class mrfsk_decoder
+    {
+     protected:
+        msg_queue::sptr d_target_queue;
+        gr::basic_block *d_owner;
+        mrfsk_rx_stats &d_stats;
+        boost::atomic<bool> d_lossy;    // drop instead of waiting on a full target_queue
+        boost::atomic<int> d_max_length;        // longest PSDU accepted from a PHR
+        boost::atomic<bool> d_preempt;  // a new SFD restarts a frame in progress
+        bool d_active;
+        MRFSK_PHR_t phr;
+        message::sptr d_msg;    // sized to frame_length once PHR is in
+        std::vector<uint8_t> d_buf;     // instead, when no target_queue
+        uint8_t *d_psdu;        // in d_msg or d_buf
+        long d_type;            // 0 uncoded, 1 NRNSC
+        bool start_frame(long type);
+        void end_frame(void);
+
+     public:
+        mrfsk_decoder(msg_queue::sptr target_queue, gr::basic_block *owner,
+                mrfsk_rx_stats &stats);
+        virtual ~mrfsk_decoder();
+
+        void set_lossy(bool lossy) { d_lossy.store(lossy, boost::memory_order_relaxed); }
+        void set_max_frame_length(int max_frame_length)
+        {
+            d_max_length.store(max_frame_length, boost::memory_order_relaxed);
+        }
+        void set_preempt(bool preempt) { d_preempt.store(preempt, boost::memory_order_relaxed); }
+        bool preempt() const { return d_preempt.load(boost::memory_order_relaxed); }
+        bool active() const { return d_active; }
+        /* frame in progress is dropped, search for SFD resumes */
+        void abort(void) { d_active = false; d_msg.reset(); }
+        virtual void start(void) = 0;
+        virtual void push_bit(int bit) = 0;
+        /* takes octets until the frame is done, returns how many */
+        virtual int push_octets(const uint8_t *in, int n) = 0;
+
+        /* correlator output: bit 0 data, bit 1 flags first bit after SFD;
+         * with preempt, a flag inside a frame restarts on it */
+        void push_flagged(const uint8_t *in, int n);
+    };
+
+    class mrfsk_uncoded_decoder : public mrfsk_decoder
+    {
+     private:
+        int d_headerbitlen_cnt;
+        unsigned char d_packet_byte_index, d_packet_byte;
+        uint16_t d_packetlen_cnt;
+
+     public:
+        mrfsk_uncoded_decoder(msg_queue::sptr target_queue, gr::basic_block *owner,
+                mrfsk_rx_stats &stats);
+
+        void start(void);
+        void push_bit(int bit);
+        int push_octets(const uint8_t *in, int n);
+    };
+
+    class mrfsk_nrnsc_decoder : public mrfsk_decoder
+    {
+     private:
+        uint32_t rf_buf;
+        char rf_buf_bitlen_cnt;
+        uint8_t ppui, pui;
+        void decode_ui(uint8_t);
+        int weights[NUM_WEIGHTS];
+        void shift_weights(void);
+        void push_decoded_bit(void);
+        void decode_block(void);
+        uint8_t phr_buf[PHR_LENGTH];
+        uint16_t phr_psdu_buf_idx;
+        int phr_psdu_buf_idx_stop;
+        uint8_t db_bp;
+
+     public:
+        mrfsk_nrnsc_decoder(msg_queue::sptr target_queue, gr::basic_block *owner,
+                mrfsk_rx_stats &stats);
+
+        void start(void);
+        void push_bit(int bit);
+        int push_octets(const uint8_t *in, int n);
+    };
+
+    /*
+     * NRNSC by soft decision Viterbi. Soft coded bits, positive for a one
+     * over the air, are deinterleaved a block at a time and run through the
+     * trellis as they come. PHR is traced back from the best state once 48
+     * bits are decoded, the shortest possible frame; the whole frame from
+     * the state the tail and pad end in. Hard bits count as full scale.
+     */
+    class mrfsk_soft_nrnsc_decoder : public mrfsk_decoder
+    {
+     private:
+        int8_t d_block[32];     // one interleaver block as received
+        int d_nsym;
+        int8_t d_soft[32];
+        int16_t d_metric[NRNSC_STATES];
+        std::vector<uint8_t> d_decisions;       // one octet per input bit
+        std::vector<uint8_t> d_bits;            // traceback
+        size_t d_steps;
+        size_t d_steps_stop;    // 0 until PHR is in
+
+     public:
+        mrfsk_soft_nrnsc_decoder(msg_queue::sptr target_queue, gr::basic_block *owner,
+                mrfsk_rx_stats &stats);
+
+        void start(void);
+        void push_bit(int bit);
+        int push_octets(const uint8_t *in, int n);
+        void push_soft(int8_t soft);
+    };
+
+    /*
+     * Tail of preamble plus SFD for uncoded (0x904e) and NRNSC (0x6f4e)
+     * frames, matched by Hamming distance against the last input bits,
+     * newest at the LSbit, each within its own threshold. Both codes are
+     * 8 bits apart.
+     */
+    class mrfsk_dual_sfd
+    {
+     private:
+        uint64_t d_code_uncoded;
+        uint64_t d_code_nrnsc;
+        uint64_t d_mask;
+        int d_threshold_uncoded;
+        int d_threshold_nrnsc;
+
+     public:
+        enum { SFD_NONE, SFD_UNCODED, SFD_NRNSC };
+
+        /* preamble_bits 0..48 */
+        mrfsk_dual_sfd(int preamble_bits, int threshold_uncoded, int threshold_nrnsc);
+
+        int match(uint64_t sr, int threshold_uncoded, int threshold_nrnsc) const
+        {
+            int du = __builtin_popcountll((sr & d_mask) ^ d_code_uncoded);
+            int dn = __builtin_popcountll((sr & d_mask) ^ d_code_nrnsc);
+
+            if (du > threshold_uncoded)
+                return dn > threshold_nrnsc ? SFD_NONE : SFD_NRNSC;
+            return dn > threshold_nrnsc || du <= dn ? SFD_UNCODED : SFD_NRNSC;
+        }
+        int match(uint64_t sr, int threshold) const { return match(sr, threshold, threshold); }
+        int match(uint64_t sr) const { return match(sr, d_threshold_uncoded, d_threshold_nrnsc); }
+    };
+
+    /*
+     * Packed input, 8 bits per item MSbit first. A stream tag marks the item
+     * holding the first bit after SFD, its value is that bit's position from
+     * the MSbit. Octets are realigned to the SFD on the way to the decoder.
+     * With preempt, the next tag inside a frame restarts on it.
+     */
+    class mrfsk_packed_sfd
+    {
+     private:
+        int d_shift;            // bits of first item after SFD that precede it
+        uint8_t d_prev;         // previous packed item, its low bits start next octet
+        int d_tail_bits;        // bits of d_prev used by last frame, 0 if none left
+        int sync_bit(const tag_t &tag) const;
+
+     public:
+        mrfsk_packed_sfd();
+
+        /* first item that may hold an SFD tag for a buffer starting at nr */
+        uint64_t tags_from(uint64_t nr) const { return d_tail_bits ? nr - 1 : nr; }
+
+        void work(mrfsk_decoder &dec, const uint8_t *in, int n, uint64_t nr,
+                const std::vector<tag_t> &tags);
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_MRFSK_DECODER_H */
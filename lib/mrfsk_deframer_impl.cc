@@ -0,0 +1,151 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "mrfsk_deframer_impl.h"
+
+namespace gr {
+  namespace ieee802154g {
+
+    mrfsk_deframer::sptr
+    mrfsk_deframer::make(msg_queue::sptr target_queue, int preamble_bits, int threshold)
+    {
+      return gnuradio::get_initial_sptr
+        (new mrfsk_deframer_impl(target_queue, preamble_bits, threshold, threshold));
+    }
+
+    mrfsk_deframer::sptr
+    mrfsk_deframer::make(msg_queue::sptr target_queue, int preamble_bits,
+            int threshold_uncoded, int threshold_nrnsc)
+    {
+      return gnuradio::get_initial_sptr
+        (new mrfsk_deframer_impl(target_queue, preamble_bits, threshold_uncoded, threshold_nrnsc));
+    }
+
+    /*
+     * The private constructor
+     */
+    mrfsk_deframer_impl::mrfsk_deframer_impl(msg_queue::sptr target_queue, int preamble_bits,
+            int threshold_uncoded, int threshold_nrnsc)
+      : gr::sync_block("mrfsk_deframer",
+              gr::io_signature::make(1, 1, sizeof(unsigned char)),
+              gr::io_signature::make(0, 0, 0)),
+              d_uncoded(target_queue, this, d_stats), d_nrnsc(target_queue, this, d_stats), d_dec(NULL),
+              d_sfd(preamble_bits, threshold_uncoded, threshold_nrnsc)
+    {
+        d_sr = 0;
+        d_preempt = false;
+        message_port_register_out(pmt::mp("pdus"));
+        message_port_register_out(pmt::mp("stats"));
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    mrfsk_deframer_impl::~mrfsk_deframer_impl()
+    {
+    }
+
+    void
+    mrfsk_deframer_impl::set_lossy(bool lossy)
+    {
+        d_uncoded.set_lossy(lossy);
+        d_nrnsc.set_lossy(lossy);
+    }
+
+    void
+    mrfsk_deframer_impl::set_max_frame_length(int max_frame_length)
+    {
+        d_uncoded.set_max_frame_length(max_frame_length);
+        d_nrnsc.set_max_frame_length(max_frame_length);
+    }
+
+    void
+    mrfsk_deframer_impl::set_preempt(bool preempt)
+    {
+        d_preempt.store(preempt, boost::memory_order_relaxed);
+    }
+
+    void
+    mrfsk_deframer_impl::set_stats_interval(double seconds)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        d_stats.set_interval(seconds);
+    }
+
+    void
+    mrfsk_deframer_impl::setup_rpc()
+    {
+#ifdef GR_CTRLPORT
+        mrfsk_rx_stats_rpc(this);
+#endif /* GR_CTRLPORT */
+    }
+
+    int
+    mrfsk_deframer_impl::work(int noutput_items,
+			  gr_vector_const_void_star &input_items,
+			  gr_vector_void_star &output_items)
+    {
+        const unsigned char *in = (const unsigned char *) input_items[0];
+        uint64_t sr = d_sr;
+        bool preempt = d_preempt.load(boost::memory_order_relaxed);
+        int i;
+
+        for (i = 0; i < noutput_items; i++) {
+            int bit = in[i] & 1;
+            int sfd = mrfsk_dual_sfd::SFD_NONE;
+
+            /* both codes in one pass, on the bits just before this one; in
+             * a frame only a clean SFD counts */
+            if (!d_dec || !d_dec->active())
+                sfd = d_sfd.match(sr);
+            else if (preempt)
+                sfd = d_sfd.match(sr, 0);
+            if (sfd != mrfsk_dual_sfd::SFD_NONE) {
+                if (d_dec)
+                    d_dec->abort();
+                if (sfd == mrfsk_dual_sfd::SFD_UNCODED)
+                    d_dec = &d_uncoded;
+                else
+                    d_dec = &d_nrnsc;
+                d_dec->start();
+            }
+            if (d_dec && d_dec->active())
+                d_dec->push_bit(bit);
+            sr = (sr << 1) | bit;
+        }
+        d_sr = sr;
+
+        {
+            /* not over decoding: it may wait on a full target_queue */
+            gr::thread::scoped_lock guard(d_setlock);
+            d_stats.poll(this);
+        }
+
+        // Tell runtime system how many output items we produced.
+        return noutput_items;
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
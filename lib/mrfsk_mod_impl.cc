@@ -0,0 +1,176 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "mrfsk_mod_impl.h"
+#include <algorithm>
+
+namespace gr {
+  namespace ieee802154g {
+
+    mrfsk_mod::sptr
+    mrfsk_mod::make(int sps, float mod_index, float bt, float rm, int steps)
+    {
+      return gnuradio::get_initial_sptr
+        (new mrfsk_mod_impl(sps, mod_index, bt, rm, steps));
+    }
+
+    /*
+     * The private constructor
+     */
+    mrfsk_mod_impl::mrfsk_mod_impl(int sps, float mod_index, float bt, float rm, int steps)
+      : gr::sync_interpolator("mrfsk_mod",
+              gr::io_signature::make(1, 1, sizeof(unsigned char)),
+              gr::io_signature::make(1, 1, sizeof(gr_complex)), 8 * sps),
+        mod(sps, mod_index, bt)
+    {
+        interp = 8 * sps;
+        real_max = rm;
+        if (steps < 1)
+            steps = 1;
+        ramp_steps = steps;
+        ramp_idx = 0;   // start off
+        ramp_dir = 0;
+
+        /* burst tags need more than offset scaling, see forward_tags() */
+        set_tag_propagation_policy(TPP_DONT);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    mrfsk_mod_impl::~mrfsk_mod_impl()
+    {
+    }
+
+    void
+    mrfsk_mod_impl::set_k(float rm)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        real_max = rm;
+    }
+
+    void
+    mrfsk_mod_impl::set_steps(int s)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        if (s > 0) {
+            /* keep the same fraction of full power */
+            ramp_idx = ramp_idx * s / ramp_steps;
+            ramp_steps = s;
+        }
+    }
+
+    /* same envelope as pa_ramp: first sample after the tag is one step in */
+    void
+    mrfsk_mod_impl::pa_enable(bool on)
+    {
+        if (on) {
+            ramp_idx = 1;
+            ramp_dir = ramp_idx < ramp_steps ? 1 : 0;
+        } else {
+            ramp_idx = ramp_steps - 1;
+            ramp_dir = ramp_idx > 0 ? -1 : 0;
+        }
+    }
+
+    /* octet tags onto samples: burst end on the last sample of its octet,
+     * and packet_len counted in samples */
+    void
+    mrfsk_mod_impl::forward_tags(const std::vector<tag_t> &tags)
+    {
+        static const pmt::pmt_t tx_eob = pmt::mp("tx_eob");
+        static const pmt::pmt_t packet_len = pmt::mp("packet_len");
+        unsigned int t;
+
+        for (t = 0; t < tags.size(); t++) {
+            uint64_t offset = tags[t].offset * interp;
+            pmt::pmt_t value = tags[t].value;
+            if (pmt::eq(tags[t].key, tx_eob))
+                offset += interp - 1;
+            else if (pmt::eq(tags[t].key, packet_len))
+                value = pmt::from_long(pmt::to_long(value) * interp);
+            add_item_tag(0, offset, tags[t].key, value, tags[t].srcid);
+        }
+    }
+
+    int
+    mrfsk_mod_impl::work(int noutput_items,
+			  gr_vector_const_void_star &input_items,
+			  gr_vector_void_star &output_items)
+    {
+        const unsigned char *in = (const unsigned char *) input_items[0];
+        gr_complex *out = (gr_complex *) output_items[0];
+        int ninput_items = noutput_items / interp;
+        uint64_t nr = nitems_read(0);
+        std::vector<tag_t> tags, all_tags;
+        unsigned int t = 0;
+        int i = 0, end, k;
+        gr::thread::scoped_lock guard(d_setlock);
+
+        get_tags_in_range(all_tags, 0, nr, nr + ninput_items);
+        forward_tags(all_tags);
+        get_tags_in_range(tags, 0, nr, nr + ninput_items, pmt::string_to_symbol("pa_ramp"));
+
+        while (i < ninput_items) {
+            /* tags are on octets, and so on output symbol boundaries */
+            while (t < tags.size() && tags[t].offset - nr <= (uint64_t)i)
+                pa_enable(pmt::to_long(tags[t++].value) != 0);
+            end = t < tags.size() ? tags[t].offset - nr : ninput_items;
+
+            while (i < end) {
+                gr_complex *o = out + i * interp;
+                if (ramp_dir == 0) {
+                    /* steady: one gain to the next tag */
+                    float gain = real_max * ramp_idx / ramp_steps;
+                    if (ramp_idx == 0) {
+                        mod.advance(in + i, end - i);
+                        std::fill(o, o + (end - i) * interp, gr_complex(0, 0));
+                    } else
+                        mod.modulate(in + i, end - i, o, gain);
+                    i = end;
+                } else {
+                    /* ramping: per-sample envelope, one octet at a time */
+                    mod.modulate(in + i, 1, o, 1.0);
+                    for (k = 0; k < interp; k++) {
+                        o[k] *= real_max * ramp_idx / ramp_steps;
+                        if (ramp_dir > 0 && ++ramp_idx >= ramp_steps) {
+                            ramp_idx = ramp_steps;
+                            ramp_dir = 0;   // done ramping
+                        } else if (ramp_dir < 0 && --ramp_idx <= 0) {
+                            ramp_idx = 0;
+                            ramp_dir = 0;   // done ramping
+                        }
+                    }
+                    i++;
+                }
+            }
+        }
+
+        // Tell runtime system how many output items we produced.
+        return noutput_items;
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
@@ -0,0 +1,58 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_MRFSK_MOD_IMPL_H
+#define INCLUDED_IEEE802154G_MRFSK_MOD_IMPL_H
+
+#include <ieee802154g/mrfsk_mod.h>
+#include "mrfsk_modulator.h"
+
+namespace gr {
+  namespace ieee802154g {
+
+    class mrfsk_mod_impl : public mrfsk_mod
+    {
+     private:
+        mrfsk_modulator mod;
+        int interp;     // samples per octet
+        float real_max;
+        int ramp_steps;
+        int ramp_idx;   // amplitude is ramp_idx * real_max / ramp_steps
+        int ramp_dir;   // +1 ramping up, -1 down, 0 steady
+        void pa_enable(bool on);
+        void forward_tags(const std::vector<tag_t> &tags);
+
+     public:
+      mrfsk_mod_impl(int sps, float mod_index, float bt, float rm, int steps);
+      ~mrfsk_mod_impl();
+
+      void set_k(float rm);
+      void set_steps(int s);
+
+      // Where all the action really happens
+      int work(int noutput_items,
+	       gr_vector_const_void_star &input_items,
+	       gr_vector_void_star &output_items);
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_MRFSK_MOD_IMPL_H */
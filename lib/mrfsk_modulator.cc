@@ -0,0 +1,141 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mrfsk_modulator.h"
+#include <gnuradio/fxpt.h>
+#include <math.h>
+
+namespace gr {
+  namespace ieee802154g {
+
+    /* radians to gr::fxpt angle, any range, wrapping like the accumulator */
+    static uint32_t
+    phase_to_fixed(double x)
+    {
+        return (uint32_t)(int64_t)llrint(x * (2147483648.0 / M_PI));
+    }
+
+    mrfsk_modulator::mrfsk_modulator(int sps, float mod_index, float bt)
+    {
+        int i, j, k, p;
+        int ntaps = 4 * sps;
+        double sensitivity = M_PI * mod_index / sps;    // radians per sample at full deviation
+        std::vector<double> gaussian(ntaps), taps(ntaps + sps - 1, 0.0);
+        double scale = 0, s, t0;
+
+        d_sps = sps;
+        d_phase = 0;
+        d_hist = 0;
+
+        /* as firdes::gaussian(1, sps, bt, 4*sps) */
+        s = 1.0 / (sqrt(log(2.0)) / (2 * M_PI * bt));
+        t0 = -0.5 * ntaps;
+        for (i = 0; i < ntaps; i++) {
+            double ts;
+            t0++;
+            ts = s * t0 / sps;
+            gaussian[i] = exp(-0.5 * ts * ts);
+            scale += gaussian[i];
+        }
+        /* convolved with one symbol of rectangle */
+        for (i = 0; i < ntaps; i++)
+            for (j = 0; j < sps; j++)
+                taps[i + j] += gaussian[i] / scale;
+
+        /* sample j of a symbol is sum of bit[m-k] * taps[k*sps + j], bits as -1/+1 */
+        d_phase_table.resize((1 << MRFSK_MOD_SPAN) * sps);
+        for (p = 0; p < (1 << MRFSK_MOD_SPAN); p++) {
+            double phase = 0;
+            for (j = 0; j < sps; j++) {
+                double f = 0;
+                for (k = 0; k < MRFSK_MOD_SPAN && k * sps + j < (int)taps.size(); k++)
+                    f += ((p >> k) & 1 ? 1.0 : -1.0) * taps[k * sps + j];
+                phase += sensitivity * f;
+                d_phase_table[p * sps + j] = phase_to_fixed(phase);
+            }
+        }
+    }
+
+    void
+    mrfsk_modulator::modulate(const uint8_t *in, int nbytes, gr_complex *out, float gain)
+    {
+        int i, j;
+        uint8_t bp;
+        float s, c;
+
+        for (i = 0; i < nbytes; i++) {
+            for (bp = 0x80; bp != 0; bp >>= 1) {
+                const uint32_t *ph;
+                d_hist = ((d_hist << 1) | ((in[i] & bp) ? 1 : 0)) & ((1 << MRFSK_MOD_SPAN) - 1);
+                ph = &d_phase_table[d_hist * d_sps];
+                for (j = 0; j < d_sps; j++) {
+                    gr::fxpt::sincos((int32_t)(d_phase + ph[j]), &s, &c);
+                    *out++ = gr_complex(c * gain, s * gain);
+                }
+                d_phase += ph[d_sps - 1];
+            }
+        }
+    }
+
+    void
+    mrfsk_modulator::modulate_add(const uint8_t *in, int nbytes, gr_complex *out, float gain,
+            uint32_t *nco_phase, uint32_t nco_inc)
+    {
+        int i, j;
+        uint8_t bp;
+        float s, c;
+        uint32_t nco = *nco_phase;
+
+        for (i = 0; i < nbytes; i++) {
+            for (bp = 0x80; bp != 0; bp >>= 1) {
+                const uint32_t *ph;
+                d_hist = ((d_hist << 1) | ((in[i] & bp) ? 1 : 0)) & ((1 << MRFSK_MOD_SPAN) - 1);
+                ph = &d_phase_table[d_hist * d_sps];
+                for (j = 0; j < d_sps; j++) {
+                    gr::fxpt::sincos((int32_t)(d_phase + ph[j] + nco), &s, &c);
+                    nco += nco_inc;
+                    *out++ += gr_complex(c * gain, s * gain);
+                }
+                d_phase += ph[d_sps - 1];
+            }
+        }
+        *nco_phase = nco;
+    }
+
+    void
+    mrfsk_modulator::advance(const uint8_t *in, int nbytes)
+    {
+        int i;
+        uint8_t bp;
+
+        for (i = 0; i < nbytes; i++) {
+            for (bp = 0x80; bp != 0; bp >>= 1) {
+                d_hist = ((d_hist << 1) | ((in[i] & bp) ? 1 : 0)) & ((1 << MRFSK_MOD_SPAN) - 1);
+                d_phase += d_phase_table[d_hist * d_sps + d_sps - 1];
+            }
+        }
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
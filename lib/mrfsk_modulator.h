@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_MRFSK_MODULATOR_H
+#define INCLUDED_IEEE802154G_MRFSK_MODULATOR_H
+
+#include <gnuradio/gr_complex.h>
+#include <stdint.h>
+#include <vector>
+
+#define MRFSK_MOD_SPAN  5   // symbols of Gaussian * rectangle pulse
+
+namespace gr {
+  namespace ieee802154g {
+
+    /*
+     * 2-FSK with Gaussian pulse, sample for sample the same as
+     * digital.gfsk_mod (Gaussian FIR of 4 symbols convolved with one symbol
+     * of rectangle, frequency modulator), but table driven: each output
+     * symbol depends only on the last MRFSK_MOD_SPAN bits, so the phase
+     * trajectory of every bit pattern is computed once, in fixed point.
+     */
+    class mrfsk_modulator
+    {
+     private:
+        int d_sps;
+        std::vector<uint32_t> d_phase_table;  // [pattern][sample]: phase from symbol start, gr::fxpt
+        uint32_t d_phase;   // at end of last symbol, wraps modulo 2pi
+        unsigned int d_hist;    // last MRFSK_MOD_SPAN bits, newest in bit 0
+
+     public:
+        mrfsk_modulator(int sps, float mod_index, float bt);
+
+        int sps() const { return d_sps; }
+
+        /* nbytes octets, MSbit first, to nbytes*8*sps samples of amplitude gain */
+        void modulate(const uint8_t *in, int nbytes, gr_complex *out, float gain);
+
+        /* as modulate(), shifted by nco_inc (gr::fxpt angle) per sample and
+         * added into out: the mixer is folded into the phase accumulator */
+        void modulate_add(const uint8_t *in, int nbytes, gr_complex *out, float gain,
+                uint32_t *nco_phase, uint32_t nco_inc);
+
+        /* same phase progress as modulate(), without output (TX power off) */
+        void advance(const uint8_t *in, int nbytes);
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_MRFSK_MODULATOR_H */
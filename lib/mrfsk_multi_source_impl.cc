@@ -0,0 +1,225 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "mrfsk_multi_source_impl.h"
+#include "utils_mrfsk.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+#define INIT_DELAY_OCTETS   50  // as mrfsk_source, radio sink device startup
+
+namespace gr {
+  namespace ieee802154g {
+
+    mrfsk_multi_source::sptr
+    mrfsk_multi_source::make(int sps, float mod_index, float bt, double samp_rate,
+            const std::vector<float> &freq_offsets, int preamble_size,
+            bool fec_en, bool dw, bool crc_type_16, int psdu_len,
+            int delay_bytes, float rm, int steps)
+    {
+      return gnuradio::get_initial_sptr
+        (new mrfsk_multi_source_impl(sps, mod_index, bt, samp_rate, freq_offsets,
+            preamble_size, fec_en, dw, crc_type_16, psdu_len, delay_bytes, rm, steps));
+    }
+
+    /*
+     * The private constructor
+     */
+    mrfsk_multi_source_impl::mrfsk_multi_source_impl(int sps, float mod_index, float bt,
+            double samp_rate, const std::vector<float> &freq_offsets, int preamble_size,
+            bool fec_en, bool dw, bool crc_type_16, int psdu_len,
+            int delay_bytes, float rm, int steps)
+      : gr::sync_block("mrfsk_multi_source",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(1, 1, sizeof(gr_complex))),
+        samp_rate(samp_rate)
+    {
+        uint8_t payload[aMaxPHYPacketSize];
+        int fcs_len = crc_type_16 ? 2 : 4;
+        int i, len, lead_max;
+
+        interp = 8 * sps;
+        real_max = rm;
+        if (steps < 1)
+            steps = 1;
+        ramp_steps = steps;
+        scratch.resize(interp);
+        set_output_multiple(interp);
+
+        /* incrementing octet payload, as mrfsk_source PAYLOAD_TYPE_INCR_BYTE */
+        psdu_len = std::max(psdu_len, fcs_len);
+        psdu_len = std::min(psdu_len, (int)aMaxPHYPacketSize);
+        for (i = 0; i < psdu_len - fcs_len; i++)
+            payload[i] = reverse_octet(i);
+        frame_len = mrfsk_frame_length(std::max(preamble_size, 0), fec_en, crc_type_16, i);
+        cycle.assign(frame_len + 2 + std::max(delay_bytes, 1), 0x00);
+        len = mrfsk_encode_frame(&cycle[0], frame_len, preamble_size,
+                fec_en, dw, crc_type_16, payload, i);
+        if (len < 0) {
+            fprintf(stderr, "mrfsk_multi_source: bad preamble_size %d\n", preamble_size);
+            frame_len = 0;  // idle: pad and delay only
+        }
+
+        /* spread the channels over one frame period */
+        lead_max = 0;
+        for (i = 0; i < (int)freq_offsets.size(); i++) {
+            mc_channel_t ch(sps, mod_index, bt);
+            ch.nco_phase = 0;
+            ch.nco_inc = offset_to_inc(freq_offsets[i]);
+            ch.lead = INIT_DELAY_OCTETS + (int)((int64_t)i * cycle.size() / freq_offsets.size());
+            ch.pos = 0;
+            ch.ramp_idx = 0;    // start off
+            ch.ramp_dir = 0;
+            lead_max = std::max(lead_max, ch.lead);
+            channels.push_back(ch);
+        }
+        lead_ff.assign(lead_max, 0xff);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    mrfsk_multi_source_impl::~mrfsk_multi_source_impl()
+    {
+    }
+
+    uint32_t
+    mrfsk_multi_source_impl::offset_to_inc(float offset)
+    {
+        return (uint32_t)(int64_t)llrint(offset / samp_rate * 4294967296.0);
+    }
+
+    void
+    mrfsk_multi_source_impl::set_k(float rm)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        real_max = rm;
+    }
+
+    void
+    mrfsk_multi_source_impl::set_freq_offset(int channel, float offset)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        if (channel >= 0 && channel < (int)channels.size())
+            channels[channel].nco_inc = offset_to_inc(offset);
+    }
+
+    /* same envelope as mrfsk_mod */
+    void
+    mrfsk_multi_source_impl::pa_enable(mc_channel_t &ch, bool on)
+    {
+        if (on) {
+            ch.ramp_idx = 1;
+            ch.ramp_dir = ch.ramp_idx < ramp_steps ? 1 : 0;
+        } else {
+            ch.ramp_idx = ramp_steps - 1;
+            ch.ramp_dir = ch.ramp_idx > 0 ? -1 : 0;
+        }
+    }
+
+    /* nbytes octets of one channel, added into out */
+    void
+    mrfsk_multi_source_impl::render(mc_channel_t &ch, const uint8_t *in, int nbytes, gr_complex *out)
+    {
+        int k;
+
+        while (nbytes > 0) {
+            if (ch.ramp_dir == 0) {
+                if (ch.ramp_idx == 0) {
+                    /* TX power off: nothing to add, keep phase going */
+                    ch.mod.advance(in, nbytes);
+                    ch.nco_phase += (uint32_t)nbytes * interp * ch.nco_inc;
+                } else
+                    ch.mod.modulate_add(in, nbytes, out, real_max * ch.ramp_idx / ramp_steps,
+                            &ch.nco_phase, ch.nco_inc);
+                return;
+            }
+
+            /* ramping: per-sample envelope, one octet at a time */
+            std::fill(scratch.begin(), scratch.end(), gr_complex(0, 0));
+            ch.mod.modulate_add(in, 1, &scratch[0], 1.0, &ch.nco_phase, ch.nco_inc);
+            for (k = 0; k < interp; k++) {
+                out[k] += scratch[k] * (real_max * ch.ramp_idx / ramp_steps);
+                if (ch.ramp_dir > 0 && ++ch.ramp_idx >= ramp_steps) {
+                    ch.ramp_idx = ramp_steps;
+                    ch.ramp_dir = 0;    // done ramping
+                } else if (ch.ramp_dir < 0 && --ch.ramp_idx <= 0) {
+                    ch.ramp_idx = 0;
+                    ch.ramp_dir = 0;    // done ramping
+                }
+            }
+            in++;
+            out += interp;
+            nbytes--;
+        }
+    }
+
+    int
+    mrfsk_multi_source_impl::work(int noutput_items,
+			  gr_vector_const_void_star &input_items,
+			  gr_vector_void_star &output_items)
+    {
+        gr_complex *out = (gr_complex *) output_items[0];
+        int noctets = noutput_items / interp;
+        int cycle_len = cycle.size();
+        unsigned int c;
+        gr::thread::scoped_lock guard(d_setlock);
+
+        std::fill(out, out + noutput_items, gr_complex(0, 0));
+
+        for (c = 0; c < channels.size(); c++) {
+            mc_channel_t &ch = channels[c];
+            int i = 0, n;
+
+            while (i < noctets) {
+                if (ch.lead > 0) {
+                    n = std::min(ch.lead, noctets - i);
+                    render(ch, &lead_ff[0], n, out + i * interp);
+                    ch.lead -= n;
+                } else {
+                    /* PA on at first frame octet, off after the pad octet */
+                    if (frame_len > 0 && ch.pos == 0)
+                        pa_enable(ch, true);
+                    else if (frame_len > 0 && ch.pos == frame_len + 1)
+                        pa_enable(ch, false);
+                    n = (ch.pos <= frame_len ? frame_len + 1 : cycle_len) - ch.pos;
+                    n = std::min(n, noctets - i);
+                    render(ch, &cycle[ch.pos], n, out + i * interp);
+                    ch.pos += n;
+                    if (ch.pos == cycle_len)
+                        ch.pos = 0;
+                }
+                i += n;
+            }
+        }
+
+        // Tell runtime system how many output items we produced.
+        return noutput_items;
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
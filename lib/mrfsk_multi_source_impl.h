@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_IEEE802154G_MRFSK_MULTI_SOURCE_IMPL_H
+#define INCLUDED_IEEE802154G_MRFSK_MULTI_SOURCE_IMPL_H
+
+#include <ieee802154g/mrfsk_multi_source.h>
+#include "mrfsk_modulator.h"
+
+namespace gr {
+  namespace ieee802154g {
+
+    class mrfsk_multi_source_impl : public mrfsk_multi_source
+    {
+     private:
+        typedef struct mc_channel {
+            mrfsk_modulator mod;
+            uint32_t nco_phase, nco_inc;    // frequency offset, gr::fxpt angle
+            int lead;       // 0xff octets still to send before first frame
+            int pos;        // octet in cycle
+            int ramp_idx;   // amplitude is ramp_idx * real_max / ramp_steps
+            int ramp_dir;   // +1 ramping up, -1 down, 0 steady
+            mc_channel(int sps, float mod_index, float bt) : mod(sps, mod_index, bt) {}
+        } mc_channel_t;
+        std::vector<mc_channel_t> channels;
+        double samp_rate;
+        int interp;     // samples per octet
+        float real_max;
+        int ramp_steps;
+        /* one frame period, as mrfsk_source streams it: frame, pad octet,
+         * PA off octet, delay octets. Same for every channel. */
+        std::vector<uint8_t> cycle;
+        int frame_len;
+        std::vector<uint8_t> lead_ff;   // idle octets before the first frame
+        std::vector<gr_complex> scratch;    // one octet of samples, while ramping
+        uint32_t offset_to_inc(float offset);
+        void pa_enable(mc_channel_t &ch, bool on);
+        void render(mc_channel_t &ch, const uint8_t *in, int nbytes, gr_complex *out);
+
+     public:
+      mrfsk_multi_source_impl(int sps, float mod_index, float bt, double samp_rate,
+              const std::vector<float> &freq_offsets, int preamble_size,
+              bool fec_en, bool dw, bool crc_type_16, int psdu_len,
+              int delay_bytes, float rm, int steps);
+      ~mrfsk_multi_source_impl();
+
+      void set_k(float rm);
+      void set_freq_offset(int channel, float offset);
+
+      // Where all the action really happens
+      int work(int noutput_items,
+	       gr_vector_const_void_star &input_items,
+	       gr_vector_void_star &output_items);
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_MRFSK_MULTI_SOURCE_IMPL_H */
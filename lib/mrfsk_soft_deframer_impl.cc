@@ -0,0 +1,161 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <math.h>
+#include "mrfsk_soft_deframer_impl.h"
+
+/* mean symbol magnitude maps to this soft value, leaving room for peaks */
+#define SOFT_MEAN       32
+#define AMP_ALPHA       (1.0f / 32)     // about one preamble of symbols
+
+namespace gr {
+  namespace ieee802154g {
+
+    mrfsk_soft_deframer::sptr
+    mrfsk_soft_deframer::make(msg_queue::sptr target_queue, int preamble_bits, int threshold)
+    {
+      return gnuradio::get_initial_sptr
+        (new mrfsk_soft_deframer_impl(target_queue, preamble_bits, threshold));
+    }
+
+    /*
+     * The private constructor
+     */
+    mrfsk_soft_deframer_impl::mrfsk_soft_deframer_impl(msg_queue::sptr target_queue, int preamble_bits, int threshold)
+      : gr::sync_block("mrfsk_soft_deframer",
+              gr::io_signature::make(1, 1, sizeof(float)),
+              gr::io_signature::make(0, 0, 0)),
+              d_uncoded(target_queue, this, d_stats), d_nrnsc(target_queue, this, d_stats),
+              d_active(mrfsk_dual_sfd::SFD_NONE),
+              d_sfd(preamble_bits, threshold, threshold)
+    {
+        d_sr = 0;
+        d_preempt = false;
+        d_amp = 0;
+        d_scale = 1;
+        message_port_register_out(pmt::mp("pdus"));
+        message_port_register_out(pmt::mp("stats"));
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    mrfsk_soft_deframer_impl::~mrfsk_soft_deframer_impl()
+    {
+    }
+
+    void
+    mrfsk_soft_deframer_impl::set_lossy(bool lossy)
+    {
+        d_uncoded.set_lossy(lossy);
+        d_nrnsc.set_lossy(lossy);
+    }
+
+    void
+    mrfsk_soft_deframer_impl::set_max_frame_length(int max_frame_length)
+    {
+        d_uncoded.set_max_frame_length(max_frame_length);
+        d_nrnsc.set_max_frame_length(max_frame_length);
+    }
+
+    void
+    mrfsk_soft_deframer_impl::set_preempt(bool preempt)
+    {
+        d_preempt.store(preempt, boost::memory_order_relaxed);
+    }
+
+    void
+    mrfsk_soft_deframer_impl::set_stats_interval(double seconds)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        d_stats.set_interval(seconds);
+    }
+
+    void
+    mrfsk_soft_deframer_impl::setup_rpc()
+    {
+#ifdef GR_CTRLPORT
+        mrfsk_rx_stats_rpc(this);
+#endif /* GR_CTRLPORT */
+    }
+
+    int
+    mrfsk_soft_deframer_impl::work(int noutput_items,
+			  gr_vector_const_void_star &input_items,
+			  gr_vector_void_star &output_items)
+    {
+        const float *in = (const float *) input_items[0];
+        uint64_t sr = d_sr;
+        bool preempt = d_preempt.load(boost::memory_order_relaxed);
+        int i;
+
+        for (i = 0; i < noutput_items; i++) {
+            float x = in[i];
+            int bit = x >= 0;
+            int sfd = mrfsk_dual_sfd::SFD_NONE;
+
+            /* in a frame only a clean SFD counts */
+            if (d_active == mrfsk_dual_sfd::SFD_NONE)
+                sfd = d_sfd.match(sr);
+            else if (preempt)
+                sfd = d_sfd.match(sr, 0);
+            if (sfd != mrfsk_dual_sfd::SFD_NONE) {
+                d_uncoded.abort();
+                d_nrnsc.abort();
+                d_active = sfd;
+                d_scale = d_amp > 0 ? SOFT_MEAN / d_amp : 1;
+                if (d_active == mrfsk_dual_sfd::SFD_UNCODED)
+                    d_uncoded.start();
+                else
+                    d_nrnsc.start();
+            }
+            if (d_active == mrfsk_dual_sfd::SFD_UNCODED) {
+                d_uncoded.push_bit(bit);
+                if (!d_uncoded.active())
+                    d_active = mrfsk_dual_sfd::SFD_NONE;
+            } else if (d_active == mrfsk_dual_sfd::SFD_NRNSC) {
+                float v = rintf(x * d_scale);
+                d_nrnsc.push_soft(v > 127 ? 127 : v < -127 ? -127 : (int8_t) v);
+                if (!d_nrnsc.active())
+                    d_active = mrfsk_dual_sfd::SFD_NONE;
+            } else {
+                d_amp += (fabsf(x) - d_amp) * AMP_ALPHA;
+            }
+            sr = (sr << 1) | bit;
+        }
+        d_sr = sr;
+
+        {
+            /* not over decoding: it may wait on a full target_queue */
+            gr::thread::scoped_lock guard(d_setlock);
+            d_stats.poll(this);
+        }
+
+        // Tell runtime system how many output items we produced.
+        return noutput_items;
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
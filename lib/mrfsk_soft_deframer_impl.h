@@ -0,0 +1,71 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_MRFSK_SOFT_DEFRAMER_IMPL_H
+#define INCLUDED_IEEE802154G_MRFSK_SOFT_DEFRAMER_IMPL_H
+
+#include <ieee802154g/mrfsk_soft_deframer.h>
+#include "mrfsk_decoder.h"
+
+namespace gr {
+  namespace ieee802154g {
+
+    class mrfsk_soft_deframer_impl : public mrfsk_soft_deframer
+    {
+     private:
+        mrfsk_rx_stats d_stats;         // ahead of the decoders using it
+        mrfsk_uncoded_decoder d_uncoded;
+        mrfsk_soft_nrnsc_decoder d_nrnsc;
+        int d_active;                   // SFD_UNCODED or SFD_NRNSC while in a frame
+        mrfsk_dual_sfd d_sfd;
+        boost::atomic<bool> d_preempt;
+        uint64_t d_sr;                  // signs of last 64 symbols, newest at LSbit
+        float d_amp;                    // running mean of |input|
+        float d_scale;                  // to soft bits, fixed for the frame
+
+     public:
+      mrfsk_soft_deframer_impl(msg_queue::sptr target_queue, int preamble_bits, int threshold);
+      ~mrfsk_soft_deframer_impl();
+
+      void set_lossy(bool lossy);
+      uint64_t dropped() const { return d_stats.dropped; }
+      void set_max_frame_length(int max_frame_length);
+      void set_preempt(bool preempt);
+      uint64_t sfd_uncoded() const { return d_stats.sfd_uncoded; }
+      uint64_t sfd_nrnsc() const { return d_stats.sfd_nrnsc; }
+      uint64_t phr_rejects() const { return d_stats.phr_rejects; }
+      uint64_t crc16_ok() const { return d_stats.crc16_ok; }
+      uint64_t crc16_fail() const { return d_stats.crc16_fail; }
+      uint64_t crc32_ok() const { return d_stats.crc32_ok; }
+      uint64_t crc32_fail() const { return d_stats.crc32_fail; }
+      uint64_t octets() const { return d_stats.octets; }
+      void set_stats_interval(double seconds);
+      void setup_rpc();
+
+      // Where all the action really happens
+      int work(int noutput_items,
+	       gr_vector_const_void_star &input_items,
+	       gr_vector_void_star &output_items);
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_MRFSK_SOFT_DEFRAMER_IMPL_H */
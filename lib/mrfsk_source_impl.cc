@@ -24,7 +24,11 @@
 
 #include <gnuradio/io_signature.h>
 #include "mrfsk_source_impl.h"
+#include "block_stats.h"
+#include <boost/bind.hpp>
+#include <algorithm>
 #include <stdio.h>
+#include <string.h>
 
 
 namespace gr {
@@ -42,7 +46,22 @@ namespace gr {
         int delay_bytes
     ) {
       return gnuradio::get_initial_sptr
-        (new mrfsk_source_impl(num_iterations, preamble_size, fec_en, dw, crc_type_16, payload_type, psdu_len, delay_bytes));
+        (new mrfsk_source_impl(num_iterations, preamble_size, fec_en, dw, crc_type_16, payload_type, psdu_len, delay_bytes, 0));
+    }
+
+    mrfsk_source::sptr
+    mrfsk_source::make(
+        int preamble_size,
+        bool fec_en,
+        bool dw,
+        bool crc_type_16,
+        int delay_bytes,
+        int queue_depth
+    ) {
+      if (queue_depth < 1)
+        queue_depth = 1;
+      return gnuradio::get_initial_sptr
+        (new mrfsk_source_impl(0, preamble_size, fec_en, dw, crc_type_16, PAYLOAD_TYPE_INCR_BYTE, 0, delay_bytes, queue_depth));
     }
 
     /*
@@ -56,12 +75,18 @@ namespace gr {
         bool crc_type_16,
         char payload_type,
         int psdu_len,
-        int delay_bytes
+        int delay_bytes,
+        int queue_depth
     ) : gr::sync_block("mrfsk_source",
               gr::io_signature::make(0, 0, 0),
-              gr::io_signature::make(1, 1, sizeof(unsigned char)))
+              gr::io_signature::make(1, 1, sizeof(unsigned char))),
+        ota_ring(queue_depth),
+        ring_head(0),
+        ring_tail(0),
+        arena_head(0),
+        drop_count(0)
     {
-        preamble_bytes = preamble_size;
+        preamble_bytes = std::max(preamble_size, 0);
         nrnsc = fec_en;
         dw_en = dw;
         fcs_type = crc_type_16;
@@ -69,15 +94,49 @@ namespace gr {
         pkt_countdown = num_iterations;
 
         payload_content_type = payload_type;
+        psdu_len_req = psdu_len;
+        update_psdu_size();
+        rf_buf_valid = false;
+
+        /* frames from PDUs instead of generated payload */
+        pdu_mode = queue_depth > 0;
+        dropping = false;
+        if (pdu_mode) {
+            /* room for queue_depth frames of the longest PSDU; grows later
+             * when a longer preamble needs it and the queue has drained */
+            ota_arena.resize(queue_depth * mrfsk_frame_length(preamble_bytes,
+                        1, 0, aMaxPHYPacketSize - 4));
+            message_port_register_in(pmt::mp("pdus"));
+            set_msg_handler(pmt::mp("pdus"),
+                boost::bind(&mrfsk_source_impl::pdu_in, this, _1));
+        }
+
+        burst = false;
+        timed = false;
+
+        state = STATE_INIT_DELAY;
+        delay_countdown = 50;   // radio sink device startup time?
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    mrfsk_source_impl::~mrfsk_source_impl()
+    {
+    }
+
+    void
+    mrfsk_source_impl::update_psdu_size()
+    {
         if (payload_content_type == PAYLOAD_TYPE_CRC_TEST) {
-            if (crc_type_16)
+            if (fcs_type)
                 psdu_size = 5;
             else
                 psdu_size = 7;
         } else {
-            psdu_size = psdu_len;
+            psdu_size = std::min(psdu_len_req, (int)aMaxPHYPacketSize);
             // make sure length is at least enough to hold crc
-            if (crc_type_16) {
+            if (fcs_type) {
                 if (psdu_size < 2)
                     psdu_size = 2;
             } else {
@@ -85,16 +144,225 @@ namespace gr {
                     psdu_size = 4;
             }
         }
+    }
 
-        state = STATE_INIT_DELAY;
-        delay_countdown = 50;   // radio sink device startup time?
+    void
+    mrfsk_source_impl::set_preamble_size(int preamble_size)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        preamble_bytes = std::max(preamble_size, 0);
+        rf_buf_valid = false;
     }
 
-    /*
-     * Our virtual destructor.
-     */
-    mrfsk_source_impl::~mrfsk_source_impl()
+    void
+    mrfsk_source_impl::set_fec_en(bool fec_en)
     {
+        gr::thread::scoped_lock guard(d_setlock);
+        nrnsc = fec_en;
+        rf_buf_valid = false;
+    }
+
+    void
+    mrfsk_source_impl::set_dw(bool dw)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        dw_en = dw;
+        rf_buf_valid = false;
+    }
+
+    void
+    mrfsk_source_impl::set_crc_type_16(bool crc_type_16)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        fcs_type = crc_type_16;
+        update_psdu_size();
+        rf_buf_valid = false;
+    }
+
+    void
+    mrfsk_source_impl::set_payload_type(char payload_type)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        payload_content_type = payload_type;
+        update_psdu_size();
+        rf_buf_valid = false;
+    }
+
+    void
+    mrfsk_source_impl::set_psdu_len(int psdu_len)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        psdu_len_req = psdu_len;
+        update_psdu_size();
+        rf_buf_valid = false;
+    }
+
+    void
+    mrfsk_source_impl::set_delay_bytes(int delay_bytes)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        delay_total = delay_bytes;
+    }
+
+    void
+    mrfsk_source_impl::set_burst_mode(bool burst_en, double symbol_rate, double start_time)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        burst = burst_en;
+        octet_time = symbol_rate > 0 ? 8.0 / symbol_rate : 0;
+        timed = burst_en && start_time > 0 && symbol_rate > 0;
+        burst_secs = (uint64_t)start_time;
+        burst_frac = start_time - burst_secs;
+    }
+
+    void
+    mrfsk_source_impl::setup_rpc()
+    {
+#ifdef GR_CTRLPORT
+        static const block_stats_var<mrfsk_source_impl> vars[] = {
+            { "pdus_dropped", &mrfsk_source_impl::pdus_dropped, "PDUs dropped, frame queue full" },
+        };
+
+        block_stats_rpc(this, vars);
+#endif /* GR_CTRLPORT */
+    }
+
+    /* tx_sob, packet_len and tx_time, on first octet of burst */
+    void
+    mrfsk_source_impl::burst_start(int sent, int len, pmt::pmt_t tx_time)
+    {
+        const uint64_t offset = this->nitems_written(0) + sent;
+
+        add_item_tag(0, offset, pmt::mp("tx_sob"), pmt::PMT_T);
+        add_item_tag(0, offset, pmt::mp("packet_len"), pmt::from_long(len));
+        if (pmt::is_tuple(tx_time)) {
+            /* frame has its own time: schedule continues from there */
+            burst_secs = pmt::to_uint64(pmt::tuple_ref(tx_time, 0));
+            burst_frac = pmt::to_double(pmt::tuple_ref(tx_time, 1));
+        } else if (!timed)
+            return;
+        add_item_tag(0, offset, pmt::mp("tx_time"),
+            pmt::make_tuple(pmt::from_uint64(burst_secs), pmt::from_double(burst_frac)));
+    }
+
+    /* next burst goes out as long after this one as in the continuous stream */
+    void
+    mrfsk_source_impl::burst_next(int octets)
+    {
+        uint64_t whole;
+
+        burst_frac += octets * octet_time;
+        whole = (uint64_t)burst_frac;
+        burst_secs += whole;
+        burst_frac -= whole;
+    }
+
+    /* Contiguous len octets of ota_arena after the newest queued frame, or
+     * from the start of the arena when the end is too short. Never lets
+     * arena_head catch up with the oldest frame, so that equal means empty. */
+    bool
+    mrfsk_source_impl::arena_alloc(size_t len, unsigned int head, unsigned int tail, size_t *off)
+    {
+        size_t oldest;
+
+        if (head == tail) {
+            /* consumer is done with the arena: start over, grow if needed */
+            if (len > ota_arena.size())
+                ota_arena.resize(len);
+            *off = 0;
+            return true;
+        }
+
+        oldest = ota_ring[tail % ota_ring.size()].off;
+        if (arena_head > oldest) {
+            if (arena_head + len <= ota_arena.size())
+                *off = arena_head;
+            else if (len < oldest)
+                *off = 0;
+            else
+                return false;
+        } else {
+            if (arena_head + len < oldest)
+                *off = arena_head;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    /* PDU is (metadata . u8vector payload without FCS). Optional metadata
+     * keys fec_en, dw and crc_type_16 override the block settings for this
+     * frame. The frame is encoded straight into its place in ota_arena. */
+    void
+    mrfsk_source_impl::pdu_in(pmt::pmt_t msg)
+    {
+        bool fec, whiten, fcs16;
+        pmt::pmt_t tx_time = pmt::PMT_NIL;
+        int preamble, len;
+        unsigned int head, tail;
+        ota_frame_t *frame;
+        const uint8_t *payload;
+        size_t payload_len, ota_len, off;
+
+        if (!pmt::is_pair(msg) || !pmt::is_u8vector(pmt::cdr(msg))) {
+            fprintf(stderr, "mrfsk_source: PDU must be (meta . u8vector)\n");
+            return;
+        }
+
+        pmt::pmt_t meta = pmt::car(msg);
+        gr::thread::scoped_lock guard(d_setlock);
+        fec = nrnsc;
+        whiten = dw_en;
+        fcs16 = fcs_type;
+        if (pmt::is_dict(meta)) {
+            fec = pmt::to_bool(pmt::dict_ref(meta, pmt::mp("fec_en"), pmt::from_bool(fec)));
+            whiten = pmt::to_bool(pmt::dict_ref(meta, pmt::mp("dw"), pmt::from_bool(whiten)));
+            fcs16 = pmt::to_bool(pmt::dict_ref(meta, pmt::mp("crc_type_16"), pmt::from_bool(fcs16)));
+            tx_time = pmt::dict_ref(meta, pmt::mp("tx_time"), pmt::PMT_NIL);
+        }
+        preamble = preamble_bytes;
+
+        payload = pmt::u8vector_elements(pmt::cdr(msg), payload_len);
+        if (payload_len > aMaxPHYPacketSize - (fcs16 ? 2 : 4)) {
+            fprintf(stderr, "mrfsk_source: PDU of %u octets too long\n", (unsigned)payload_len);
+            return;
+        }
+        ota_len = mrfsk_frame_length(preamble, fec, fcs16, payload_len);
+
+        head = ring_head;
+        tail = ring_tail;
+        /* counted in pdus_dropped(), reported once per run of drops */
+        if (head - tail >= ota_ring.size()) {
+            drop_count.fetch_add(1, boost::memory_order_relaxed);
+            if (!dropping)
+                fprintf(stderr, "mrfsk_source: frame queue full, dropping PDUs\n");
+            dropping = true;
+            return;
+        }
+        if (!arena_alloc(ota_len, head, tail, &off)) {
+            /* queue has a slot, but queued frames leave no contiguous room */
+            drop_count.fetch_add(1, boost::memory_order_relaxed);
+            if (!dropping)
+                fprintf(stderr, "mrfsk_source: no room for %u octet frame behind %u queued, dropping PDUs\n",
+                        (unsigned)ota_len, head - tail);
+            dropping = true;
+            return;
+        }
+        dropping = false;
+
+        frame = &ota_ring[head % ota_ring.size()];
+        len = mrfsk_encode_frame(&ota_arena[off], ota_len, preamble,
+                fec, whiten, fcs16, payload, payload_len);
+        if (len < 0) {
+            fprintf(stderr, "mrfsk_source: PDU of %u octets too long\n", (unsigned)payload_len);
+            return;
+        }
+        arena_head = off + len;
+        frame->off = off;
+        frame->len = len;
+        frame->tx_time = tx_time;
+
+        ring_head = head + 1;
     }
 
     int
@@ -102,66 +370,154 @@ namespace gr {
 			  gr_vector_const_void_star &input_items,
 			  gr_vector_void_star &output_items)
     {
-        int i, sent = 0;
+        int n, sent = 0;
         unsigned char *out = (unsigned char *) output_items[0];
+        gr::thread::scoped_lock guard(d_setlock);
 
-        for (i = 0; i < noutput_items; i++) {
+        /* each state fills as much of its run as fits, then moves on */
+        while (sent < noutput_items) {
+            n = noutput_items - sent;
             switch (state) {
                 case STATE_INIT_DELAY:
                     if (payload_content_type == PAYLOAD_PN9_FOREVER) {
-                        lfsr = 0x1ff;
-                        out[i] = get_pn9_byte(&lfsr);
-                        state = STATE_PN9_LFSR;
+                        pn_period.assign(pn9_table, pn9_table + PN9_PERIOD);
+                        pn_idx = 0;
                         pa_enable(true, sent);
-                    } else {
-                        /* perhaps the TX sink needs a few samples to start up? */
-                        out[i] = 0xff;
-                        if (--delay_countdown == 0)
-                            state = STATE_GENERATE_PACKET;
+                        state = STATE_PN_FOREVER;
+                        break;
                     }
+                    if (payload_content_type == PAYLOAD_PN15_FOREVER) {
+                        pn_period.resize(PN15_PERIOD);
+                        pn15_generate(&pn_period[0], PN15_PERIOD);
+                        pn_idx = 0;
+                        pa_enable(true, sent);
+                        state = STATE_PN_FOREVER;
+                        break;
+                    }
+                    if (burst) {
+                        /* nothing is streamed outside of bursts */
+                        state = STATE_GENERATE_PACKET;
+                        break;
+                    }
+                    /* perhaps the TX sink needs a few samples to start up? */
+                    if (n > delay_countdown)
+                        n = delay_countdown;
+                    memset(out + sent, 0xff, n);
+                    sent += n;
+                    delay_countdown -= n;
+                    if (delay_countdown <= 0)
+                        state = STATE_GENERATE_PACKET;
                     break;
                 case STATE_GENERATE_PACKET:
-                    generate_packet();
-                    rf_buf_sent = 0;
-                    out[i] = rf_buf[rf_buf_sent++];
+                    if (pdu_mode) {
+                        if (ring_head == ring_tail) {
+                            if (burst) {
+                                /* nothing streams between bursts. A source is
+                                 * run again as soon as it returns, and pdu_in()
+                                 * runs on this thread between work() calls, so
+                                 * sleep in short steps until a PDU is waiting
+                                 * on the port, then return for it to be handed
+                                 * over. Bounded so stop() is not held up. */
+                                if (sent > 0)
+                                    return sent;
+                                guard.unlock();
+                                for (n = 0; n < 100 && empty_p(pmt::mp("pdus")); n++)
+                                    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+                                return 0;
+                            }
+                            /* nothing queued: idle with TX power off */
+                            memset(out + sent, 0x00, n);
+                            sent += n;
+                            break;
+                        }
+                        const ota_frame_t &frame = ota_ring[ring_tail % ota_ring.size()];
+                        tx_buf = &ota_arena[frame.off];
+                        tx_len = frame.len;
+                        tx_time = frame.tx_time;
+                    } else {
+                        /* same frame every time, until a setting changes */
+                        if (!rf_buf_valid && !generate_packet()) {
+                            state = STATE_DONE;
+                            return sent;
+                        }
+                        tx_buf = &rf_buf[0];
+                        tx_len = rf_buf.size();
+                        tx_time = pmt::PMT_NIL;
+                    }
+                    tx_sent = 0;
                     pa_enable(true, sent);
+                    if (burst)  // frame, pad and ramp down octet
+                        burst_start(sent, tx_len + 2, tx_time);
                     state = STATE_SEND_PACKET;
                     break;
                 case STATE_SEND_PACKET:
-                    out[i] = rf_buf[rf_buf_sent++];
-                    if (rf_buf_sent >= rf_buf_len)
+                    if (n > tx_len - tx_sent)
+                        n = tx_len - tx_sent;
+                    if (n > 0)
+                        memcpy(out + sent, tx_buf + tx_sent, n);
+                    sent += n;
+                    tx_sent += n;
+                    if (tx_sent >= tx_len) {
+                        if (pdu_mode)   // arena space free for next PDU
+                            ring_tail++;
                         state = STATE_PAD;
+                    }
                     break;
                 case STATE_PAD:
                     /* prevent corruption of last bit */
-                    out[i] = 0x00;
+                    out[sent++] = 0x00;
                     state = STATE_DELAY_START;
                     break;
                 case STATE_DELAY_START:
-                    out[i] = 0x00;
+                    out[sent] = 0x00;
                     pa_enable(false, sent);
+                    if (burst) {
+                        /* gap is left to tx_time instead of streamed */
+                        add_item_tag(0, nitems_written(0) + sent, pmt::mp("tx_eob"), pmt::PMT_T);
+                        sent++;
+                        burst_next(tx_len + 2 + std::max(delay_total, 1));
+                        if (!pdu_mode && --pkt_countdown == 0) {
+                            state = STATE_DONE;
+                            return sent;
+                        }
+                        state = STATE_GENERATE_PACKET;
+                        break;
+                    }
+                    sent++;
                     delay_countdown = delay_total;
                     state = STATE_DELAY;
-                    state = STATE_DELAY;
                     break;
                 case STATE_DELAY:
-                    out[i] = 0x00;
-                    if (--delay_countdown <= 0) {
-                        if (--pkt_countdown == 0) {
+                    /* at least one octet, even with zero delay */
+                    if (delay_countdown < 1)
+                        delay_countdown = 1;
+                    if (n > delay_countdown)
+                        n = delay_countdown;
+                    memset(out + sent, 0x00, n);
+                    sent += n;
+                    delay_countdown -= n;
+                    if (delay_countdown == 0) {
+                        if (!pdu_mode && --pkt_countdown == 0) {
                             state = STATE_DONE;
-                            return sent;
+                            return sent - 1;    // final delay octet is not produced
                         } else
                             state = STATE_GENERATE_PACKET;
                     }
                     break;
                 case STATE_DONE:
                     return -1;
-                case STATE_PN9_LFSR:
-                    out[i] = get_pn9_byte(&lfsr);
+                case STATE_PN_FOREVER:
+                    /* copy out of one period, wrapping around */
+                    if (n > (int)(pn_period.size() - pn_idx))
+                        n = pn_period.size() - pn_idx;
+                    memcpy(out + sent, &pn_period[pn_idx], n);
+                    sent += n;
+                    pn_idx += n;
+                    if (pn_idx == pn_period.size())
+                        pn_idx = 0;
                     break;
             } // ..switch (state)
-            sent++;
-        } // ...for (i = 0; i < noutput_items; i++)
+        } // ..while (sent < noutput_items)
 
         // Tell runtime system how many output items we produced.
         return sent;
@@ -176,252 +532,51 @@ namespace gr {
         this->add_item_tag(0, offset, key, value);
     }
 
-    /* encode_bit: Section 18.1.2.4, NRNSC Figure 124 of 802.15.4g-2012 */
-    int
-    mrfsk_source_impl::encode_bit(uint8_t bit)
-    {
-        char ui1, ui0;
-
-        M2 = M1;
-        M1 = M0;
-        M0 = bi;
-        bi = bit ? 1 : 0;
-
-        ui1 = (bi + M1 + M2) % 2;
-        ui0 = (bi + M0 + M1 + M2) % 2;
-
-        if (ui1) {
-            rf_buf[rf_buf_len] &= ~rf_bp;
-        } else {
-            rf_buf[rf_buf_len] |= rf_bp;
-        }
-
-        rf_bp >>= 1;
-        if (rf_bp == 0) {
-            rf_bp = 0x80;
-            if (++rf_buf_len >= (int)sizeof(rf_buf))
-                return -1;
-        }
-
-        if (ui0) {
-            rf_buf[rf_buf_len] &= ~rf_bp;
-        } else {
-            rf_buf[rf_buf_len] |= rf_bp;
-        }
-
-        rf_bp >>= 1;
-        if (rf_bp == 0) {
-            rf_bp = 0x80;
-            if (++rf_buf_len >= (int)sizeof(rf_buf))
-                return -1;
-        }
-
-        return 0;
-    }
-
-    void
+    bool
     mrfsk_source_impl::generate_packet()
     {
-        int i;
-        uint16_t phr_psdu_buf_idx;
-        uint8_t phr_psdu_buf[2050];
-        uint8_t *psdu_buf = &phr_psdu_buf[2];
-        int psdu_buf_idx;
+        int i, len;
+        uint8_t payload[aMaxPHYPacketSize];
+        int payload_len = 0;
         uint8_t payload_incr_octet;
-        uint16_t psdu_size_wo_crc;
-
-        /* generate preamble */
-        for (rf_buf_len = 0; rf_buf_len < preamble_bytes; )
-            rf_buf[rf_buf_len++] = 0x55;
-
-        if (nrnsc) {
-            rf_buf[rf_buf_len++] = 0x6f;
-        } else
-            rf_buf[rf_buf_len++] = 0x90;
-
-        rf_buf[rf_buf_len++] = 0x4e;
-
-        phr.word = 0;
-        phr.bits.DW = dw_en;
-        phr.bits.FCS = fcs_type;
-        phr.bits.frame_length = psdu_size;
+        int psdu_size_wo_crc;
 
-        phr_psdu_buf[0] = phr.word >> 8;
-        phr_psdu_buf[1] = phr.word & 0xff;
-
-        if (phr.bits.FCS)
+        if (fcs_type)
             psdu_size_wo_crc = psdu_size - 2;
         else
             psdu_size_wo_crc = psdu_size - 4;
 
-        psdu_buf_idx = 0;
         switch (payload_content_type) {
             case PAYLOAD_TYPE_CRC_TEST: // 0x400056
-                psdu_buf[psdu_buf_idx++] = 0x40;
-                psdu_buf[psdu_buf_idx++] = 0x00;
-                psdu_buf[psdu_buf_idx++] = 0x56;
+                payload[payload_len++] = 0x40;
+                payload[payload_len++] = 0x00;
+                payload[payload_len++] = 0x56;
                 break;
             case PAYLOAD_TYPE_PN9:      // TUV conformance
-                lfsr = 0x1ff;
-                for (i = 0; i < psdu_size_wo_crc; i++)
-                    psdu_buf[psdu_buf_idx++] = get_pn9_byte(&lfsr);
+                lfsr = PN9_SEED;
+                memset(payload, 0, psdu_size_wo_crc);
+                pn9_xor(payload, psdu_size_wo_crc, &lfsr);
+                payload_len = psdu_size_wo_crc;
                 break;
             case PAYLOAD_TYPE_INCR_BYTE:   // wi-sun interop
                 payload_incr_octet = 0;
                 for (i = 0; i < psdu_size_wo_crc; i++)
-                    psdu_buf[psdu_buf_idx++] = reverse_octet(payload_incr_octet++);
+                    payload[payload_len++] = reverse_octet(payload_incr_octet++);
                 /* reverse: IEEE seems prefer LSbit first */
                 break;
             /* different payloads could be added here */
         } // ..switch (payload_content_type)
 
-
-        if (phr.bits.FCS) {
-            crc16 = INITIAL_CRC16;
-            crc16 = crc_msb_first(crc16, psdu_buf, psdu_buf_idx);
-            psdu_buf[psdu_buf_idx++] = crc16 >> 8;
-            psdu_buf[psdu_buf_idx++] = crc16 & 0xff;
-        } else {
-            uint8_t z = 0;
-            crc_32 = INITIAL_CRC32;
-            crc_32 = digital_update_crc32(crc_32, psdu_buf, psdu_buf_idx);
-            i = psdu_buf_idx;
-            while (i < 4) {
-                crc_32 = digital_update_crc32(crc_32, &z, 1);
-                i++;
-            }
-            crc_32 = ~crc_32;
-            psdu_buf[psdu_buf_idx++] = crc_32 >> 24;
-            psdu_buf[psdu_buf_idx++] = crc_32 >> 16;
-            psdu_buf[psdu_buf_idx++] = crc_32 >> 8;
-            psdu_buf[psdu_buf_idx++] = crc_32 & 0xff;
-        }
-
-        if (phr.bits.DW) {
-            lfsr = 0x1ff;
-            for (i = 0; i < psdu_buf_idx; i++)
-                psdu_buf[i] ^= get_pn9_byte(&lfsr);
-        }
-
-        phr_psdu_buf_idx = psdu_buf_idx + PHR_LENGTH;
-
-        if (nrnsc) {
-            uint16_t rf_buf_len_start = rf_buf_len;
-            M2 = 0;
-            M1 = 0;
-            M0 = 0;
-            bi = 0;
-            rf_bp = 0x80;
-            uint8_t rf_bit_cnt = 0;
-            for (i = 0; i < phr_psdu_buf_idx; i++) {
-                uint8_t bp;
-                for (bp = 0x80; bp != 0; bp >>= 1) {
-                    if (encode_bit(phr_psdu_buf[i] & bp)) {
-                        printf("fec abort\n");
-                        return;
-                    }
-                    rf_bit_cnt += 2;
-                    if (rf_bit_cnt == 32) {
-                        rf_bit_cnt = 0;
-                        interleave(&rf_buf[rf_buf_len-4]);
-                    }
-                }
-            }
-
-            if (encode_bit(0)) {    // tail
-                fprintf(stderr, "encode_bit fail\n");
-                return;
-            }
-            if (encode_bit(0)) {    // tail
-                fprintf(stderr, "encode_bit fail\n");
-                return;
-            }
-            if (encode_bit(0)) {    // tail
-                fprintf(stderr, "encode_bit fail\n");
-                return;
-            }
-            if (phr_psdu_buf_idx & 1) {
-                if (encode_bit(0)) {    // 5bit pad : 0
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 5bit pad : 1
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(0)) {    // 5bit pad : 2
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 5bit pad : 3
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 5bit pad : 4
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-
-            } else {
-                if (encode_bit(0)) {    // 13bit pad : 0
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 13bit pad : 1
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(0)) {    // 13bit pad : 2
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 13bit pad : 3
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 13bit pad : 4
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(0)) {    // 13bit pad : 5
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(0)) {    // 13bit pad : 6
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(0)) {    // 13bit pad : 7
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(0)) {    // 13bit pad : 8
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 13bit pad : 9
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(0)) {    // 13bit pad : 10
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 13bit pad : 11
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-                if (encode_bit(1)) {    // 13bit pad : 12
-                    fprintf(stderr, "encode_bit fail\n  ");
-                    return;
-                }
-            }
-            interleave(&rf_buf[rf_buf_len-4]);
-        } else {
-            /* PHR and PSDU is sent as-is over the air */
-            memcpy(rf_buf+rf_buf_len, phr_psdu_buf, phr_psdu_buf_idx);
-            rf_buf_len += phr_psdu_buf_idx;
+        /* preamble_bytes and psdu_size are kept in range by the setters */
+        rf_buf.resize(mrfsk_frame_length(preamble_bytes, nrnsc, fcs_type, payload_len));
+        len = mrfsk_encode_frame(&rf_buf[0], rf_buf.size(), preamble_bytes,
+                nrnsc, dw_en, fcs_type, payload, payload_len);
+        if (len < 0) {
+            fprintf(stderr, "mrfsk_source: can't encode %d octet PSDU\n", psdu_size);
+            return false;
         }
+        rf_buf_valid = true;
+        return true;
     } // ..generate_packet()
 
   } /* namespace ieee802154g */
@@ -22,6 +22,8 @@
 #define INCLUDED_IEEE802154G_MRFSK_SOURCE_IMPL_H
 
 #include <ieee802154g/mrfsk_source.h>
+#include <boost/atomic.hpp>
+#include <vector>
 #include "utils_mrfsk.h"
 
 namespace gr {
@@ -38,26 +40,53 @@ namespace gr {
             STATE_DELAY_START,
             STATE_DELAY,
             STATE_DONE,
-            STATE_PN9_LFSR  // RF test
+            STATE_PN_FOREVER    // RF test
         } state_e;
         state_e state;
         int preamble_bytes;
         bool nrnsc, dw_en, fcs_type;
-        int psdu_size;
+        int psdu_size, psdu_len_req;
         int delay_countdown, delay_total;
         int pkt_countdown;
-        MRFSK_PHR_t phr;
         int payload_content_type;
         uint16_t lfsr;  // PN9
-        uint16_t crc16;
-        uint32_t crc_32;
-        char M2, M1, M0, bi;    // FEC
-        void generate_packet(void);
-        uint8_t rf_buf[32+4096+4];   // over-the-air RF buffer
-        uint16_t rf_buf_len;
-        uint16_t rf_buf_sent;
-        int encode_bit(uint8_t);
-        uint8_t rf_bp;
+        std::vector<uint8_t> pn_period;     // one period of PN*_FOREVER sequence
+        size_t pn_idx;
+        bool generate_packet(void);   // false if frame can't be encoded
+        void update_psdu_size(void);
+        std::vector<uint8_t> rf_buf;    // over-the-air RF buffer, sized to frame
+        bool rf_buf_valid;      // rf_buf holds frame for current settings
+        const uint8_t *tx_buf;  // frame being sent: rf_buf or in ota_arena
+        int tx_len, tx_sent;
+        pmt::pmt_t tx_time;     // of frame being sent, from PDU metadata
+
+        bool burst;     // only frames are streamed, tagged for UHD sink
+        bool timed;     // bursts carry tx_time
+        double octet_time;
+        uint64_t burst_secs;    // tx_time of next burst
+        double burst_frac;
+        void burst_start(int sent, int len, pmt::pmt_t tx_time);
+        void burst_next(int octets);
+
+        typedef struct {
+            size_t off;         // in ota_arena
+            int len;
+            pmt::pmt_t tx_time;
+        } ota_frame_t;
+        bool pdu_mode;
+        /* encoded PDU frames, queued by pdu_in() and sent by work(). Frames
+         * are packed back to back in ota_arena, each taking only its own
+         * over-the-air length; ring order is arena order. The scheduler runs
+         * pdu_in() on the block thread between work() calls, and both hold
+         * d_setlock, so the indices need no other synchronization. */
+        std::vector<ota_frame_t> ota_ring;
+        unsigned int ring_head, ring_tail;
+        std::vector<uint8_t> ota_arena;
+        size_t arena_head;      // end of newest frame
+        bool arena_alloc(size_t len, unsigned int head, unsigned int tail, size_t *off);
+        boost::atomic<uint64_t> drop_count;
+        bool dropping;          // last PDU was dropped, cause already reported
+        void pdu_in(pmt::pmt_t msg);
         void pa_enable(bool en, int sent);
 
      public:
@@ -69,10 +98,22 @@ namespace gr {
         bool crc_type_16,
         char payload_type,
         int psdu_len,
-        int delay_bytes
+        int delay_bytes,
+        int queue_depth
       );
       ~mrfsk_source_impl();
 
+      void set_preamble_size(int preamble_size);
+      void set_fec_en(bool fec_en);
+      void set_dw(bool dw);
+      void set_crc_type_16(bool crc_type_16);
+      void set_payload_type(char payload_type);
+      void set_psdu_len(int psdu_len);
+      void set_delay_bytes(int delay_bytes);
+      void set_burst_mode(bool burst, double symbol_rate, double start_time);
+      uint64_t pdus_dropped() const { return drop_count; }
+      void setup_rpc();
+
       // Where all the action really happens
       int work(int noutput_items,
 	       gr_vector_const_void_star &input_items,
@@ -49,6 +49,7 @@ namespace gr {
         d_k = gr_complex(0.0, 0.0); // start off
         dir_up = false;
         dir_down = false;
+        tx_on = false;
 
         if (steps == 0)
             steps = 1;
@@ -133,8 +134,6 @@ namespace gr {
     void
     pa_ramp_impl::ramp()
     {
-        static bool tx_on = false;
-
         if (dir_up) {
             if (++table_idx >= ramp_steps) {
                 tx_on = true;
@@ -32,6 +32,7 @@ namespace gr {
         gr_complex d_k;
         float real_max;
         bool dir_up, dir_down, new_gain;
+        bool tx_on;     // ramped up, for continuous TX gain changes
         void ramp(void);
         int ramp_steps;
         void make_ramp_table(int);
@@ -22,7 +22,8 @@
  * packets, where the preamble is a repeating 0xAA or 0x55 pattern at start of packet.
  * It is intended to take the place of clock_recovery_mm_ff for this specific use.
  * The input of this block should be driven by quad demod, and output to binary slicer.
- * Samples per symbol is best in the range 3 to 20.
+ * Samples per symbol is best in the range 2 to 20. Symbols are sampled between input
+ * samples where the averaged zero crossings put them, by cubic interpolation.
  *
  * You might find it desirable to use a simple squelch before the quad demod to reduce
  * unwanted activity from background noise.
@@ -35,415 +36,179 @@
 
 #include <gnuradio/io_signature.h>
 #include "preamble_detector_impl.h"
-//#ifdef P_DEBUG
+#include "preamble_scan.h"
+#ifdef P_DEBUG
 #include <stdio.h>
-//#endif /* P_DEBUG */
+#endif /* P_DEBUG */
 
 
 namespace gr {
   namespace ieee802154g {
 
+    template <int SPS>
+    static preamble_detector::sptr
+    make_impl(int samples_per_symbol, int avg_windows, int lock_windows,
+        int drift_windows, float freq_tolerance)
+    {
+      return gnuradio::get_initial_sptr
+        (new preamble_detector_impl<SPS>(samples_per_symbol,
+            avg_windows, lock_windows, drift_windows, freq_tolerance));
+    }
+
     preamble_detector::sptr
     preamble_detector::make(int samples_per_symbol)
     {
-      return gnuradio::get_initial_sptr
-        (new preamble_detector_impl(samples_per_symbol));
+      return make(samples_per_symbol, 3, 6, 4, 0.1f);
+    }
+
+    preamble_detector::sptr
+    preamble_detector::make(int samples_per_symbol, int avg_windows, int lock_windows,
+        int drift_windows, float freq_tolerance)
+    {
+      switch (samples_per_symbol) {
+      case 4:
+        return make_impl<4>(4, avg_windows, lock_windows, drift_windows, freq_tolerance);
+      case 5:
+        return make_impl<5>(5, avg_windows, lock_windows, drift_windows, freq_tolerance);
+      case 8:
+        return make_impl<8>(8, avg_windows, lock_windows, drift_windows, freq_tolerance);
+      case 10:
+        return make_impl<10>(10, avg_windows, lock_windows, drift_windows, freq_tolerance);
+      case 16:
+        return make_impl<16>(16, avg_windows, lock_windows, drift_windows, freq_tolerance);
+      default:
+        return make_impl<0>(samples_per_symbol,
+            avg_windows, lock_windows, drift_windows, freq_tolerance);
+      }
     }
 
     /*
      * The private constructor
      */
-    preamble_detector_impl::preamble_detector_impl(int samples_per_symbol)
+    template <int SPS>
+    preamble_detector_impl<SPS>::preamble_detector_impl(int samples_per_symbol,
+        int avg_windows, int lock_windows, int drift_windows, float freq_tolerance)
       : gr::sync_decimator("preamble_detector",
               gr::io_signature::make(1, 1, sizeof(float)),
               gr::io_signature::make(1, 1, sizeof(float)), samples_per_symbol),
-                sps(samples_per_symbol)
+                sps_x2(samples_per_symbol * 2),
+                d_scan(false),
+                d_sync(samples_per_symbol)
     {
+#ifdef HAVE_PREAMBLE_SCAN
+        d_scan = SPS != 0 && cpu_has_avx2();
+#endif /* HAVE_PREAMBLE_SCAN */
+        d_sync.set_thresholds(avg_windows, lock_windows, drift_windows, freq_tolerance);
         set_output_multiple(2);
-        state = STATE_NONE;
-        mid_idx = 0;
-        s_tol = sps / 4;
-        if (s_tol == 0)
-            s_tol = 1;
-        s_tol++;
-#ifdef P_DEBUG
-        printf("s_tol:%d\n", s_tol);
-#endif /* P_DEBUG */
-        preamble_cnt = 0;
+        /* one sample before and two after each window for the interpolator */
+        set_history(4);
 
-        zcu_sum_cnt = 0;
-        zcd_sum_cnt = 0;
+        message_port_register_out(pmt::mp("stats"));
+    }
 
-        sps_half = sps / 2.0;
-        sps_x2 = sps * 2;
+    /*
+     * Our virtual destructor.
+     */
+    template <int SPS>
+    preamble_detector_impl<SPS>::~preamble_detector_impl()
+    {
+    }
 
-        int_sample_point_a = sps;
-        int_sample_point_b = sps;
+    template <int SPS>
+    void
+    preamble_detector_impl<SPS>::set_thresholds(int avg_windows, int lock_windows,
+        int drift_windows, float freq_tolerance)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        d_sync.set_thresholds(avg_windows, lock_windows, drift_windows, freq_tolerance);
+    }
 
-        zcu_forced = false;
-        zcd_forced = false;
+    template <int SPS>
+    void
+    preamble_detector_impl<SPS>::set_stats_interval(double seconds)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        d_sync.stats().set_interval(seconds);
+    }
 
-        f_offset = 0;
+    template <int SPS>
+    void
+    preamble_detector_impl<SPS>::setup_rpc()
+    {
+#ifdef GR_CTRLPORT
+        preamble_sync_rpc(this);
+#endif /* GR_CTRLPORT */
     }
 
-    /*
-     * Our virtual destructor.
-     */
-    preamble_detector_impl::~preamble_detector_impl()
+    /* fixed SPS: each window in one pass, crossings of the mid of the one before */
+    template <int SPS>
+    int
+    preamble_detector_impl<SPS>::work_scan(int noutput_items, const float *in, float *out)
     {
+#ifdef HAVE_PREAMBLE_SCAN
+        for (int i = 0; i < noutput_items; in += 2 * SPS) {
+            preamble_window_t w;
+            int zcu_at, zcd_at;
+
+            /* SPS 0 never gets here, but needs a length to compile */
+            preamble_scan<SPS ? 2 * SPS : 8>(in, d_sync.mid(), &w, &zcu_at, &zcd_at);
+            if (d_sync.work_2ui(in, w, zcu_at, zcd_at))
+                return -1;
+            out[i++] = d_sync.sample_a(in);
+            out[i++] = d_sync.sample_b(in);
+        }
+#endif /* HAVE_PREAMBLE_SCAN */
+        return 0;
     }
 
+    template <int SPS>
     int
-    preamble_detector_impl::work(int noutput_items,
+    preamble_detector_impl<SPS>::work(int noutput_items,
 			  gr_vector_const_void_star &input_items,
 			  gr_vector_void_star &output_items)
     {
-        const float *in = (const float *) input_items[0];
+        const float *in = (const float *) input_items[0] + 1;
         float *out = (float *) output_items[0];
 
         int j = 0, i = 0;
-        bool first = true;
-        int idx;
 
-        for (; i < noutput_items; ) {
-            if (work_2ui(first, &in[j]))
+        gr::thread::scoped_lock guard(d_setlock);
+
+        if (d_scan) {
+            if (work_scan(noutput_items, in, out))
                 return -1;
-            out[i] = in[j+int_sample_point_a];
-            out[i++] -= f_offset;
-            out[i] = in[j+int_sample_point_b];
-            out[i++] -= f_offset;
-            first = false;
-            j += sps_x2;
-        } // ..for (int i = 0; i < noutput_items; i++)
+        } else {
+            /* min, max and squelch don't depend on state: all windows at once */
+            if ((int)d_windows.size() < noutput_items / 2)
+                d_windows.resize(noutput_items / 2);
+            preamble_windows(&d_windows[0], in, sps_x2, noutput_items / 2);
+
+            for (; i < noutput_items; ) {
+                if (d_sync.work_2ui(&in[j], d_windows[i / 2]))
+                    return -1;
+                out[i++] = d_sync.sample_a(&in[j]);
+                out[i++] = d_sync.sample_b(&in[j]);
+                j += sps_x2;
+            } // ..for (int i = 0; i < noutput_items; i++)
+        }
 
 #ifdef P_DEBUG
-        if (dbg_num_zeros < sps_x2)
-            printf(" exit work %d:%d\n", noutput_items, i);
+        if (!d_sync.squelched())
+            printf(" exit work %d\n", noutput_items);
 #endif /* P_DEBUG */
 
+        d_sync.stats().poll(this);
+
         // Tell runtime system how many output items we produced.
         return noutput_items;
     } // ..work()
 
-    int
-    preamble_detector_impl::work_2ui(bool _first, const float *in_)
-    {
-            int n;
-            bool flipped = false;
-            float min_val = 1000, max_val = -1000;
-            int min_val_at = -1, max_val_at = -1;
-            int zcu_at = -1, zcd_at = -1;
-            dbg_num_zeros = 0;
-            for (n = 0; n < sps_x2; n++) {
-                if (in_[n] == 0)
-                    dbg_num_zeros++;
-
-                if (in_[n] < min_val) {
-                    min_val = in_[n];
-                    min_val_at  = n;
-                }
-                if (in_[n] > max_val) {
-                    max_val = in_[n];
-                    max_val_at  = n;
-                }
-                if (!_first || n > 0) {
-                    if (in_[n-1] < mid_avg && in_[n] >= mid_avg)
-                        zcu_at = n;
-                    else if (in_[n-1] >= mid_avg && in_[n] < mid_avg)
-                        zcd_at = n;
-                }
-            }
-
-            if (dbg_num_zeros == sps_x2) {
-                return 0;   // nothing to do (squelched)
-            }
-
-            /*if (_first)*/ {
-                int diff_zcu = abs(zcu_at - prev_zcu_at);
-                int diff_zcd = abs(zcd_at - prev_zcd_at);
-#ifdef P_DEBUG
-                printf("DIFF:%d,%d ", diff_zcu, diff_zcd); 
-#endif /* P_DEBUG */
-                if (abs(diff_zcu-sps) < s_tol && abs(diff_zcd-sps) < s_tol) {
-                    int itmp;
-                    float ftmp;
-                    // this occurs when work() returns in middle of preamble
-                    flipped = true;
-#ifdef P_DEBUG
-                    printf(" [43mFLIP");
-                    printf("zcu@%d(%d) zcd@%d(%d)[0m ", zcu_at, prev_zcu_at, zcd_at, prev_zcd_at);
-#endif /* P_DEBUG */
-                    itmp = zcu_at;
-                    zcu_at = zcd_at;
-                    zcd_at = itmp;
-
-                    itmp = prev_zcu_at;
-                    prev_zcu_at = prev_zcd_at;
-                    prev_zcd_at = itmp;
-
-                    ftmp = zcu_sum;
-                    zcu_sum = zcd_sum;
-                    zcd_sum = ftmp;
-
-                    itmp = zcu_sum_cnt;
-                    zcu_sum_cnt = zcd_sum_cnt;
-                    zcd_sum_cnt = itmp;
-
-                    // if this occurs, were not in preamble
-                    if (preamble_cnt > 0)
-                        preamble_cnt--;
-                }
-            } // if first iteration
-
-            float prev_mid = mids[mid_idx];
-            mids[mid_idx] = get_mid(min_val, max_val);
-            float fshift = fabs(prev_mid - mids[mid_idx]);
-            if (++mid_idx == NUM_MIDS)
-                mid_idx = 0;
-            int mi = mid_idx;
-            float sum = 0;
-            for (int c = 0; c < NUM_MIDS; c++) {
-                sum += mids[mi++];
-                if (mi == NUM_MIDS)
-                    mi = 0;
-            }
-            mid_avg = sum / NUM_MIDS;
-
-            int peaks_tol = abs( abs(min_val_at-max_val_at) - sps );
-#ifdef P_DEBUG
-            printf("pt:%d ", peaks_tol);
-            if (peaks_tol < s_tol)
-                printf("*");
-            else
-                printf(" ");
-#endif /* P_DEBUG */
-
-            if (zcd_at == 0 && prev_zcd_at >= (sps_x2-1)) {
-#ifdef P_DEBUG
-                printf(" [35mdFORCE-HI[0m ");
-#endif /* P_DEBUG */
-                zcd_at = sps_x2;
-                prev_zcd_at = sps_x2-1;
-                zcd_forced = true;
-            } else {
-                if (zcd_forced && zcd_at < 2 && zcd_at != -1) {
-#ifdef P_DEBUG
-                    printf("reset-zcd ");
-#endif /* P_DEBUG */
-                    zcd_sum = zcd_at;
-                    zcd_sum_cnt = 1;
-                }
-                zcd_forced = false;
-            }
-
-            if (zcu_at == 0 && prev_zcu_at >= (sps_x2-1)) {
-#ifdef P_DEBUG
-                printf(" [35muFORCE-HI[0m ");
-#endif /* P_DEBUG */
-                zcu_at = sps_x2;
-                prev_zcu_at = sps_x2-1;
-                zcu_forced = true;
-            } else {
-                if (zcu_forced && zcu_at < 2 && zcu_at != -1) {
-#ifdef P_DEBUG
-                    printf("reset-zcu ");
-#endif /* P_DEBUG */
-                    zcu_sum = zcd_at;
-                    zcu_sum_cnt = 1;
-                }
-                zcu_forced = false;
-            }
-
-            int zc_tol = sps;
-            if (zcu_at != -1 && zcd_at != -1) {
-                zc_tol = abs( abs(zcu_at-zcd_at) - sps );
-#ifdef P_DEBUG
-                if (zc_tol < s_tol)
-                    printf("#");
-                else
-                    printf(" ");
-#endif /* P_DEBUG */
-            } else {
-#ifdef P_DEBUG
-                printf(" ");
-#endif /* P_DEBUG */
-                if (preamble_cnt > 0)
-                    preamble_cnt--;
-            }
-
-            if (peaks_tol < s_tol && zc_tol < s_tol) {
-                if (zcu_at == -1 || zcd_at == -1) {
-                    /* prevent false preamble detection inside packet */
-                    if (preamble_cnt > 0)
-                        preamble_cnt--;
-                } else
-                    preamble_cnt++;
-
-                if (preamble_cnt == 3) {
-                    if (zcu_at == -1) {
-                        zcu_sum = 0;
-                        zcu_sum_cnt = 0;
-                    } else {
-                        zcu_sum = zcu_at;
-                        zcu_sum_cnt = 1;
-                    }
-                    if (zcd_at == -1) {
-                        zcd_sum = 0;
-                        zcd_sum_cnt = 0;
-                    } else {
-                        zcd_sum = zcd_at;
-                        zcd_sum_cnt = 1;
-                    }
-                }
-            } else if (peaks_tol >= s_tol && zc_tol >= s_tol)
-                preamble_cnt = 0;
-
-            if (preamble_cnt > 3 && zcu_at != -1 && zcd_at != -1) {
-                if (abs(prev_zcu_at - zcu_at) >= (sps_x2-1)) {
-                    /* zero crossing is straddling edge */
-                    zcu_sum_cnt = 1;
-                    zcu_sum = zcu_at;
-                } else {
-                    zcu_sum_cnt++;
-                    zcu_sum += zcu_at;
-                }
-
-                if (abs(prev_zcd_at - zcd_at) >= (sps_x2-1)) {
-                    /* zero crossing is straddling edge */
-                    zcd_sum_cnt = 1;
-                    zcd_sum = zcd_at;
-                } else {
-                    zcd_sum_cnt++;
-                    zcd_sum += zcd_at;
-                }
-            }
-
-            /* only update sample point when have preamble with stable center frequency */
-            if (fshift < ((max_val-min_val)/10)) {
-                if (preamble_cnt > 6) {
-                    float zcu_at_f = zcu_sum / zcu_sum_cnt;
-                    float zcd_at_f = zcd_sum / zcd_sum_cnt;
-                    float prev_spa = sample_point_a;
-                    float prev_spb = sample_point_b;
-                    if (zcu_at_f > zcd_at_f) {
-                        // zcd_at is first in time
-                        if (zcd_at_f < sps_half) {
-                            sample_point_a = zcd_at_f + sps_half;
-                            sample_point_b = zcu_at_f + sps_half;
-#ifdef P_DEBUG
-                            printf("SPa:%.2f,%.2f ", sample_point_a, sample_point_b);
-#endif /* P_DEBUG */
-                        } else {
-                            sample_point_a = zcd_at_f - sps_half;
-                            sample_point_b = zcu_at_f - sps_half;
-#ifdef P_DEBUG
-                            printf("SPc:%.2f,%.2f ", sample_point_a, sample_point_b);
-#endif /* P_DEBUG */
-                        }
-                    } else {
-                        // zcu_at is first in time
-                        if (zcu_at_f < sps_half) {
-                            sample_point_a = zcu_at_f + sps_half;
-                            sample_point_b = zcd_at_f + sps_half;
-#ifdef P_DEBUG
-                            printf("SPb:%.2f,%.2f ", sample_point_a, sample_point_b);
-#endif /* P_DEBUG */
-                        } else {
-                            sample_point_a = zcu_at_f - sps_half;
-                            sample_point_b = zcd_at_f - sps_half;
-#ifdef P_DEBUG
-                            printf("SPd:%.2f,%.2f ", sample_point_a, sample_point_b);
-#endif /* P_DEBUG */
-                        }
-                    }
-
-#ifdef P_DEBUG
-                    float sdiff = fabs(sample_point_a - sample_point_b);
-                    if (sdiff < (sps_half-1)) {
-                        printf("\n[41msdiff:%.3f (a%.3f b%.3f) zcu_at_f:%.3f zcd_at_f:%.3f\n", sdiff, sample_point_a, sample_point_b, zcu_at_f, zcd_at_f);
-                        printf("zcu_sum:%.3f zcu_sum_cnt:%d\n", zcu_sum, zcu_sum_cnt);
-                        printf("zcd_sum:%.3f zcd_sum_cnt:%d\n ", zcd_sum, zcd_sum_cnt);
-                        printf("[0m\n");
-                        return -1;
-                    }
-                    if (prev_spa != sample_point_a) {
-                        printf("[36mnew spa:%.3f->%.3f[0m ", prev_spa, sample_point_a);
-                    }
-                    if (prev_spb != sample_point_b) {
-                        printf("[36mnew spb:%.3f->%.3f[0m ", prev_spb, sample_point_b);
-                    }
-#endif /* P_DEBUG */
-
-                    int_sample_point_a = round(sample_point_a);
-                    if (int_sample_point_a == sps_x2) {
-#ifdef P_DEBUG
-                        printf("[41mspa-wrap[0m ");
-#endif /* P_DEBUG */
-                        int_sample_point_a = 0;
-                        int_sample_point_b = sps;
-                    }
-                    int_sample_point_b = round(sample_point_b);
-                    if (int_sample_point_b == sps_x2) {
-#ifdef P_DEBUG
-                        printf("[41mspb-wrap[0m ");
-#endif /* P_DEBUG */
-                        int_sample_point_a = 0;
-                        int_sample_point_b = sps;
-                    }
-                    f_offset = mid_avg;
-                } // ...if (preamble_cnt > 6)
-            } // ..if center frequency stable
-            else if (preamble_cnt > 4)
-                preamble_cnt -= 4; // drifting center frequency
-
-#ifdef P_DEBUG
-            printf("min=% .3f@%2d max=% .3f@%2d | % .3f | zcu@%d(%d) zcd@%d(%d) ",
-                min_val, min_val_at, max_val, max_val_at,
-                mid_avg,
-                zcu_at, prev_zcu_at, zcd_at, prev_zcd_at
-            );
-            if (preamble_cnt > 6)
-                printf("pc:[32m%02d[0m ", preamble_cnt);
-            else
-                printf("pc:%02d ", preamble_cnt);
-
-            if (preamble_cnt > 3) {
-                printf("[zcavgs:%.2f %.2f]   ",
-                    zcu_sum / zcu_sum_cnt,
-                    zcd_sum / zcd_sum_cnt
-                );
-            }
-            printf("[33m%d %d[0m ", int_sample_point_a, int_sample_point_b);
-#endif /* P_DEBUG */
-
-            if (!flipped) {
-                if (zcu_at != -1)
-                    prev_zcu_at = zcu_at;
-                if (zcd_at != -1)
-                    prev_zcd_at = zcd_at;
-            }
-
-#ifdef P_DEBUG
-            printf("\n");
-#endif /* P_DEBUG */
-        return 0;
-    }
-
-    float
-    preamble_detector_impl::get_mid(float a, float b)
-    {
-        if (a < 0 && b < 0)
-            return (a + b) / 2;
-        else if (a > 0 && b > 0)
-            return (a + b) / 2;
-        else
-            return a + b;
-
-#ifdef P_DEBUG
-        //printf(" mid=% 01.3f ", mid);
-#endif /* P_DEBUG */
-    }
-
+    template class preamble_detector_impl<0>;
+    template class preamble_detector_impl<4>;
+    template class preamble_detector_impl<5>;
+    template class preamble_detector_impl<8>;
+    template class preamble_detector_impl<10>;
+    template class preamble_detector_impl<16>;
 
   } /* namespace ieee802154g */
 } /* namespace gr */
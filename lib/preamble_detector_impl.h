@@ -22,8 +22,8 @@
 #define INCLUDED_IEEE802154G_PREAMBLE_DETECTOR_IMPL_H
 
 #include <ieee802154g/preamble_detector.h>
-
-#define NUM_MIDS        4
+#include <vector>
+#include "preamble_sync.h"
 
 typedef struct {
     float min_val;
@@ -35,50 +35,38 @@ typedef struct {
 namespace gr {
   namespace ieee802154g {
 
+    /*
+     * SPS 0 takes samples_per_symbol at run time; others are made for the
+     * rates in use, with windows scanned by fixed-length kernels.
+     */
+    template <int SPS>
     class preamble_detector_impl : public preamble_detector
     {
      private:
-        enum state_e { STATE_NONE, STATE_HAVE_PREAMBLE };
-        state_e state;
-
-        int sps;
-        float sps_half;
         int sps_x2;
+        bool d_scan;            // fixed-length kernels run on this CPU
+        preamble_sync d_sync;
+        std::vector<preamble_window_t> d_windows;   // of one work() call
 
-        int s_tol;
-        int preamble_cnt;
-
-        int zcu_sum_cnt;
-        int zcd_sum_cnt;
-
-        float zcu_sum;
-        float zcd_sum;
-
-        float sample_point_a;
-        float sample_point_b;
-        int int_sample_point_a;
-        int int_sample_point_b;
-
-        int prev_zcu_at;
-        int prev_zcd_at;
-
-        int work_2ui(bool first, const float *in);
-
-        int dbg_num_zeros;
-
-        bool zcu_forced;
-        bool zcd_forced;
-
-        float mids[NUM_MIDS];
-        int mid_idx;
-        float mid_avg;
-        float get_mid(float a, float b);
-        float f_offset; // AFC
+        int work_scan(int noutput_items, const float *in, float *out);
 
      public:
-      preamble_detector_impl(int samples_per_symbol);
+      preamble_detector_impl(int samples_per_symbol, int avg_windows,
+          int lock_windows, int drift_windows, float freq_tolerance);
       ~preamble_detector_impl();
 
+      void set_thresholds(int avg_windows, int lock_windows,
+          int drift_windows, float freq_tolerance);
+      int avg_windows() const { return d_sync.avg_windows(); }
+      int lock_windows() const { return d_sync.lock_windows(); }
+      int drift_windows() const { return d_sync.drift_windows(); }
+      float freq_tolerance() const { return d_sync.freq_tolerance(); }
+
+      uint64_t locks() const { return d_sync.locks(); }
+      uint64_t false_locks() const { return d_sync.false_locks(); }
+      void set_stats_interval(double seconds);
+      void setup_rpc();
+
       // Where all the action really happens
       int work(int noutput_items,
 	       gr_vector_const_void_star &input_items,
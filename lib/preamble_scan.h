@@ -0,0 +1,113 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_PREAMBLE_SCAN_H
+#define INCLUDED_IEEE802154G_PREAMBLE_SCAN_H
+
+#include "utils_mrfsk.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HAVE_PREAMBLE_SCAN 1
+#include <immintrin.h>
+#endif
+
+namespace gr {
+  namespace ieee802154g {
+
+#ifdef HAVE_PREAMBLE_SCAN
+    /*
+     * preamble_windows() and preamble_crossings() of one window of LEN
+     * samples in a single pass, for LEN known at compile time: the whole
+     * window is loaded once into LEN/8 registers and every loop is
+     * unrolled. Same results as those two, bit for bit, with in[-1] read.
+     * Only when cpu_has_avx2(); LEN 64 at most.
+     */
+    template <int LEN>
+    __attribute__((target("avx2,bmi")))
+    static inline void
+    preamble_scan(const float *in, float mid, preamble_window_t *o,
+        int *zcu_at, int *zcd_at)
+    {
+        enum { NV = (LEN + 7) / 8, TAIL = LEN & 7 };
+        const uint64_t valid = LEN == 64 ? ~0ULL : (1ULL << LEN) - 1;
+        const __m256i tail = _mm256_cmpgt_epi32(_mm256_set1_epi32(TAIL),
+            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        const __m256 init_min = _mm256_set1_ps(PREAMBLE_WINDOW_MIN);
+        const __m256 init_max = _mm256_set1_ps(PREAMBLE_WINDOW_MAX);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 m = _mm256_set1_ps(mid);
+        __m256 x[NV], vmin = init_min, vmax = init_max, nz = zero;
+        uint64_t g = 0, l = 0, up, dn, mmin = 0, mmax = 0;
+        __m128 h;
+        int v;
+
+        for (v = 0; v < NV; v++) {
+            if (TAIL != 0 && v == NV - 1) {
+                /* masked lanes load as 0, masked off g and l below */
+                x[v] = _mm256_maskload_ps(in + v * 8, tail);
+                vmin = _mm256_min_ps(_mm256_blendv_ps(init_min, x[v], _mm256_castsi256_ps(tail)), vmin);
+                vmax = _mm256_max_ps(_mm256_blendv_ps(init_max, x[v], _mm256_castsi256_ps(tail)), vmax);
+            } else {
+                x[v] = _mm256_loadu_ps(in + v * 8);
+                vmin = _mm256_min_ps(x[v], vmin);
+                vmax = _mm256_max_ps(x[v], vmax);
+            }
+            nz = _mm256_or_ps(nz, _mm256_cmp_ps(x[v], zero, _CMP_NEQ_UQ));
+            g |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(x[v], m, _CMP_GE_OQ)) << (v * 8);
+            l |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(x[v], m, _CMP_LT_OQ)) << (v * 8);
+        }
+        g &= valid;
+        l &= valid;
+        up = ((l << 1) | (in[-1] < mid)) & g;
+        dn = ((g << 1) | (in[-1] >= mid)) & l;
+        *zcu_at = up ? 63 - __builtin_clzll(up) : -1;
+        *zcd_at = dn ? 63 - __builtin_clzll(dn) : -1;
+        o->zeros = _mm256_movemask_ps(nz) == 0;
+
+        h = _mm_min_ps(_mm256_castps256_ps128(vmin), _mm256_extractf128_ps(vmin, 1));
+        h = _mm_min_ps(h, _mm_movehl_ps(h, h));
+        o->min_val = _mm_cvtss_f32(_mm_min_ss(h, _mm_shuffle_ps(h, h, 1)));
+        h = _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+        h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+        o->max_val = _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, 1)));
+
+        /* first index of each, from the registers */
+        vmin = _mm256_set1_ps(o->min_val);
+        vmax = _mm256_set1_ps(o->max_val);
+        for (v = 0; v < NV; v++) {
+            mmin |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(x[v], vmin, _CMP_EQ_OQ)) << (v * 8);
+            mmax |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(x[v], vmax, _CMP_EQ_OQ)) << (v * 8);
+        }
+        mmin &= valid;
+        mmax &= valid;
+        o->min_at = o->min_val < PREAMBLE_WINDOW_MIN ? __builtin_ctzll(mmin) : -1;
+        o->max_at = o->max_val > PREAMBLE_WINDOW_MAX ? __builtin_ctzll(mmax) : -1;
+        /* min_ps and max_ps pick either of +0 and -0, take the sample */
+        if (o->min_at >= 0)
+            o->min_val = in[o->min_at];
+        if (o->max_at >= 0)
+            o->max_val = in[o->max_at];
+    }
+#endif /* HAVE_PREAMBLE_SCAN */
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_PREAMBLE_SCAN_H */
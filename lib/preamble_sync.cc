@@ -0,0 +1,463 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+//#define P_DEBUG 1
+
+#include "preamble_sync.h"
+#include <math.h>
+#include <stdlib.h>
+#include <stdexcept>
+#ifdef P_DEBUG
+#include <stdio.h>
+#endif /* P_DEBUG */
+
+namespace gr {
+  namespace ieee802154g {
+
+    preamble_sync_stats::preamble_sync_stats()
+      : locks(0), false_locks(0)
+    {
+    }
+
+    pmt::pmt_t
+    preamble_sync_stats::to_pmt() const
+    {
+        pmt::pmt_t d = pmt::make_dict();
+        d = pmt::dict_add(d, pmt::mp("locks"), pmt::from_uint64(locks));
+        d = pmt::dict_add(d, pmt::mp("false_locks"), pmt::from_uint64(false_locks));
+        return d;
+    }
+
+    preamble_sync::preamble_sync(int samples_per_symbol)
+      : sps(samples_per_symbol)
+    {
+        state = STATE_NONE;
+        mid_idx = 0;
+        s_tol = sps / 4;
+        if (s_tol == 0)
+            s_tol = 1;
+        s_tol++;
+#ifdef P_DEBUG
+        printf("s_tol:%d\n", s_tol);
+#endif /* P_DEBUG */
+        preamble_cnt = 0;
+        set_thresholds(3, 6, 4, 0.1f);
+
+        zcu_sum_cnt = 0;
+        zcd_sum_cnt = 0;
+
+        sps_half = sps / 2.0;
+        sps_x2 = sps * 2;
+
+        set_out_points(sps, sps);
+        points_set = false;
+        dbg_num_zeros = 0;
+
+        zcu_forced = false;
+        zcd_forced = false;
+
+        f_offset = 0;
+
+        for (int c = 0; c < NUM_MIDS; c++)
+            mids[c] = 0;
+        mid_avg = 0;
+        prev_zcu_at = -1;       // none yet
+        prev_zcd_at = -1;
+    }
+
+    void
+    preamble_sync::set_out_points(float a, float b)
+    {
+        if (a < 0)
+            a = 0;
+        if (b < 0)
+            b = 0;
+        out_idx_a = (int)a;
+        out_mu_a = a - out_idx_a;
+        out_idx_b = (int)b;
+        out_mu_b = b - out_idx_b;
+        points_set = true;
+    }
+
+    void
+    preamble_sync::set_thresholds(int avg_windows, int lock_windows,
+            int drift_windows, float freq_tolerance)
+    {
+        if (avg_windows < 1 || lock_windows < avg_windows)
+            throw std::out_of_range("need 1 <= avg_windows <= lock_windows");
+        if (drift_windows < 0)
+            throw std::out_of_range("drift_windows must not be negative");
+        if (!(freq_tolerance > 0))
+            throw std::out_of_range("freq_tolerance must be positive");
+        avg_cnt = avg_windows;
+        lock_cnt = lock_windows;
+        drift_cnt = drift_windows;
+        freq_tol = freq_tolerance;
+    }
+
+    /* where in[at-1], in[at] cross mid, between at-1 and at */
+    float
+    preamble_sync::crossing_at(const float *in, int at, float mid)
+    {
+        return at - 1 + (mid - in[at-1]) / (in[at] - in[at-1]);
+    }
+
+    int
+    preamble_sync::work_2ui(const float *in, const preamble_window_t &w)
+    {
+        int zcu_at = -1, zcd_at = -1;
+
+        /* against mid_avg of the window before, so one at a time */
+        if (!w.zeros)
+            preamble_crossings(in, sps_x2, mid_avg, 0, &zcu_at, &zcd_at);
+        return work_2ui(in, w, zcu_at, zcd_at);
+    }
+
+    int
+    preamble_sync::work_2ui(const float *in_, const preamble_window_t &w,
+            int zcu_at, int zcd_at)
+    {
+            bool flipped = false;
+            points_set = false;
+            float min_val = w.min_val, max_val = w.max_val;
+            int min_val_at = w.min_at, max_val_at = w.max_at;
+            float zcu_f, zcd_f;     // fractional, for sample point
+
+            dbg_num_zeros = w.zeros ? sps_x2 : 0;
+            if (w.zeros) {
+                return 0;   // nothing to do (squelched)
+            }
+
+            zcu_f = zcu_at == -1 ? -1 : crossing_at(in_, zcu_at, mid_avg);
+            zcd_f = zcd_at == -1 ? -1 : crossing_at(in_, zcd_at, mid_avg);
+
+            {
+                int diff_zcu = abs(zcu_at - prev_zcu_at);
+                int diff_zcd = abs(zcd_at - prev_zcd_at);
+#ifdef P_DEBUG
+                printf("DIFF:%d,%d ", diff_zcu, diff_zcd); 
+#endif /* P_DEBUG */
+                if (prev_zcu_at != -1 && prev_zcd_at != -1 &&
+                        abs(diff_zcu-sps) < s_tol && abs(diff_zcd-sps) < s_tol) {
+                    int itmp;
+                    float ftmp;
+                    // this occurs when work() returns in middle of preamble
+                    flipped = true;
+#ifdef P_DEBUG
+                    printf(" [43mFLIP");
+                    printf("zcu@%d(%d) zcd@%d(%d)[0m ", zcu_at, prev_zcu_at, zcd_at, prev_zcd_at);
+#endif /* P_DEBUG */
+                    itmp = zcu_at;
+                    zcu_at = zcd_at;
+                    zcd_at = itmp;
+
+                    ftmp = zcu_f;
+                    zcu_f = zcd_f;
+                    zcd_f = ftmp;
+
+                    itmp = prev_zcu_at;
+                    prev_zcu_at = prev_zcd_at;
+                    prev_zcd_at = itmp;
+
+                    ftmp = zcu_sum;
+                    zcu_sum = zcd_sum;
+                    zcd_sum = ftmp;
+
+                    itmp = zcu_sum_cnt;
+                    zcu_sum_cnt = zcd_sum_cnt;
+                    zcd_sum_cnt = itmp;
+
+                    // if this occurs, were not in preamble
+                    if (preamble_cnt > 0)
+                        preamble_cnt--;
+                }
+            }
+
+            float prev_mid = mids[mid_idx];
+            mids[mid_idx] = get_mid(min_val, max_val);
+            float fshift = fabs(prev_mid - mids[mid_idx]);
+            if (++mid_idx == NUM_MIDS)
+                mid_idx = 0;
+            int mi = mid_idx;
+            float sum = 0;
+            for (int c = 0; c < NUM_MIDS; c++) {
+                sum += mids[mi++];
+                if (mi == NUM_MIDS)
+                    mi = 0;
+            }
+            mid_avg = sum / NUM_MIDS;
+
+            int peaks_tol = abs( abs(min_val_at-max_val_at) - sps );
+#ifdef P_DEBUG
+            printf("pt:%d ", peaks_tol);
+            if (peaks_tol < s_tol)
+                printf("*");
+            else
+                printf(" ");
+#endif /* P_DEBUG */
+
+            if (zcd_at == 0 && prev_zcd_at >= (sps_x2-1)) {
+#ifdef P_DEBUG
+                printf(" [35mdFORCE-HI[0m ");
+#endif /* P_DEBUG */
+                zcd_at = sps_x2;
+                zcd_f += sps_x2;
+                prev_zcd_at = sps_x2-1;
+                zcd_forced = true;
+            } else {
+                if (zcd_forced && zcd_at < 2 && zcd_at != -1) {
+#ifdef P_DEBUG
+                    printf("reset-zcd ");
+#endif /* P_DEBUG */
+                    zcd_sum = zcd_f;
+                    zcd_sum_cnt = 1;
+                }
+                zcd_forced = false;
+            }
+
+            if (zcu_at == 0 && prev_zcu_at >= (sps_x2-1)) {
+#ifdef P_DEBUG
+                printf(" [35muFORCE-HI[0m ");
+#endif /* P_DEBUG */
+                zcu_at = sps_x2;
+                zcu_f += sps_x2;
+                prev_zcu_at = sps_x2-1;
+                zcu_forced = true;
+            } else {
+                if (zcu_forced && zcu_at < 2 && zcu_at != -1) {
+#ifdef P_DEBUG
+                    printf("reset-zcu ");
+#endif /* P_DEBUG */
+                    zcu_sum = zcu_f;
+                    zcu_sum_cnt = 1;
+                }
+                zcu_forced = false;
+            }
+
+            int zc_tol = sps;
+            if (zcu_at != -1 && zcd_at != -1) {
+                zc_tol = abs( abs(zcu_at-zcd_at) - sps );
+#ifdef P_DEBUG
+                if (zc_tol < s_tol)
+                    printf("#");
+                else
+                    printf(" ");
+#endif /* P_DEBUG */
+            } else {
+#ifdef P_DEBUG
+                printf(" ");
+#endif /* P_DEBUG */
+                if (preamble_cnt > 0)
+                    preamble_cnt--;
+            }
+
+            if (peaks_tol < s_tol && zc_tol < s_tol) {
+                if (zcu_at == -1 || zcd_at == -1) {
+                    /* prevent false preamble detection inside packet */
+                    if (preamble_cnt > 0)
+                        preamble_cnt--;
+                } else
+                    preamble_cnt++;
+
+                if (preamble_cnt == avg_cnt) {
+                    if (zcu_at == -1) {
+                        zcu_sum = 0;
+                        zcu_sum_cnt = 0;
+                    } else {
+                        zcu_sum = zcu_f;
+                        zcu_sum_cnt = 1;
+                    }
+                    if (zcd_at == -1) {
+                        zcd_sum = 0;
+                        zcd_sum_cnt = 0;
+                    } else {
+                        zcd_sum = zcd_f;
+                        zcd_sum_cnt = 1;
+                    }
+                }
+            } else if (peaks_tol >= s_tol && zc_tol >= s_tol)
+                preamble_cnt = 0;
+
+            if (preamble_cnt > avg_cnt && zcu_at != -1 && zcd_at != -1) {
+                if (abs(prev_zcu_at - zcu_at) >= (sps_x2-1)) {
+                    /* zero crossing is straddling edge */
+                    zcu_sum_cnt = 1;
+                    zcu_sum = zcu_f;
+                } else {
+                    zcu_sum_cnt++;
+                    zcu_sum += zcu_f;
+                }
+
+                if (abs(prev_zcd_at - zcd_at) >= (sps_x2-1)) {
+                    /* zero crossing is straddling edge */
+                    zcd_sum_cnt = 1;
+                    zcd_sum = zcd_f;
+                } else {
+                    zcd_sum_cnt++;
+                    zcd_sum += zcd_f;
+                }
+            }
+
+            /* only update sample point when have preamble with stable center frequency */
+            if (fshift < (max_val-min_val) * freq_tol) {
+                if (preamble_cnt > lock_cnt) {
+                    float zcu_at_f = zcu_sum / zcu_sum_cnt;
+                    float zcd_at_f = zcd_sum / zcd_sum_cnt;
+                    float prev_spa = sample_point_a;
+                    float prev_spb = sample_point_b;
+                    if (zcu_at_f > zcd_at_f) {
+                        // zcd_at is first in time
+                        if (zcd_at_f < sps_half) {
+                            sample_point_a = zcd_at_f + sps_half;
+                            sample_point_b = zcu_at_f + sps_half;
+#ifdef P_DEBUG
+                            printf("SPa:%.2f,%.2f ", sample_point_a, sample_point_b);
+#endif /* P_DEBUG */
+                        } else {
+                            sample_point_a = zcd_at_f - sps_half;
+                            sample_point_b = zcu_at_f - sps_half;
+#ifdef P_DEBUG
+                            printf("SPc:%.2f,%.2f ", sample_point_a, sample_point_b);
+#endif /* P_DEBUG */
+                        }
+                    } else {
+                        // zcu_at is first in time
+                        if (zcu_at_f < sps_half) {
+                            sample_point_a = zcu_at_f + sps_half;
+                            sample_point_b = zcd_at_f + sps_half;
+#ifdef P_DEBUG
+                            printf("SPb:%.2f,%.2f ", sample_point_a, sample_point_b);
+#endif /* P_DEBUG */
+                        } else {
+                            sample_point_a = zcu_at_f - sps_half;
+                            sample_point_b = zcd_at_f - sps_half;
+#ifdef P_DEBUG
+                            printf("SPd:%.2f,%.2f ", sample_point_a, sample_point_b);
+#endif /* P_DEBUG */
+                        }
+                    }
+
+#ifdef P_DEBUG
+                    float sdiff = fabs(sample_point_a - sample_point_b);
+                    if (sdiff < (sps_half-1)) {
+                        printf("\n[41msdiff:%.3f (a%.3f b%.3f) zcu_at_f:%.3f zcd_at_f:%.3f\n", sdiff, sample_point_a, sample_point_b, zcu_at_f, zcd_at_f);
+                        printf("zcu_sum:%.3f zcu_sum_cnt:%d\n", zcu_sum, zcu_sum_cnt);
+                        printf("zcd_sum:%.3f zcd_sum_cnt:%d\n ", zcd_sum, zcd_sum_cnt);
+                        printf("[0m\n");
+                        return -1;
+                    }
+                    if (prev_spa != sample_point_a) {
+                        printf("[36mnew spa:%.3f->%.3f[0m ", prev_spa, sample_point_a);
+                    }
+                    if (prev_spb != sample_point_b) {
+                        printf("[36mnew spb:%.3f->%.3f[0m ", prev_spb, sample_point_b);
+                    }
+#endif /* P_DEBUG */
+
+                    /* interpolated, so only wrap past the window */
+                    float spa = sample_point_a;
+                    float spb = sample_point_b;
+                    if (spa >= sps_x2) {
+#ifdef P_DEBUG
+                        printf("[41mspa-wrap[0m ");
+#endif /* P_DEBUG */
+                        spa = 0;
+                    }
+                    if (spb >= sps_x2) {
+#ifdef P_DEBUG
+                        printf("[41mspb-wrap[0m ");
+#endif /* P_DEBUG */
+                        spa = 0;
+                        spb = sps;
+                    }
+                    set_out_points(spa, spb);
+                    f_offset = mid_avg;
+                } // ...if (preamble_cnt > lock_cnt)
+            } // ..if center frequency stable
+            else if (preamble_cnt > drift_cnt)
+                preamble_cnt -= drift_cnt; // drifting center frequency
+
+#ifdef P_DEBUG
+            printf("min=% .3f@%2d max=% .3f@%2d | % .3f | zcu@%d(%d) zcd@%d(%d) ",
+                min_val, min_val_at, max_val, max_val_at,
+                mid_avg,
+                zcu_at, prev_zcu_at, zcd_at, prev_zcd_at
+            );
+            if (preamble_cnt > lock_cnt)
+                printf("pc:[32m%02d[0m ", preamble_cnt);
+            else
+                printf("pc:%02d ", preamble_cnt);
+
+            if (preamble_cnt > avg_cnt) {
+                printf("[zcavgs:%.2f %.2f]   ",
+                    zcu_sum / zcu_sum_cnt,
+                    zcd_sum / zcd_sum_cnt
+                );
+            }
+            printf("[33m%.2f %.2f[0m ", out_idx_a + out_mu_a, out_idx_b + out_mu_b);
+#endif /* P_DEBUG */
+
+            /* lock while sample point follows preamble, as set above */
+            if (state == STATE_NONE) {
+                if (preamble_cnt > lock_cnt) {
+                    state = STATE_HAVE_PREAMBLE;
+                    locked_windows = 0;
+                    d_stats.locks.fetch_add(1, boost::memory_order_relaxed);
+                }
+            } else if (preamble_cnt <= avg_cnt) {
+                state = STATE_NONE;
+                if (locked_windows < FALSE_LOCK_WINDOWS)
+                    d_stats.false_locks.fetch_add(1, boost::memory_order_relaxed);
+            } else
+                locked_windows++;
+
+            if (!flipped) {
+                if (zcu_at != -1)
+                    prev_zcu_at = zcu_at;
+                if (zcd_at != -1)
+                    prev_zcd_at = zcd_at;
+            }
+
+#ifdef P_DEBUG
+            printf("\n");
+#endif /* P_DEBUG */
+        return 0;
+    }
+
+    float
+    preamble_sync::get_mid(float a, float b)
+    {
+        if (a < 0 && b < 0)
+            return (a + b) / 2;
+        else if (a > 0 && b > 0)
+            return (a + b) / 2;
+        else
+            return a + b;
+
+#ifdef P_DEBUG
+        //printf(" mid=% 01.3f ", mid);
+#endif /* P_DEBUG */
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
@@ -0,0 +1,164 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_PREAMBLE_SYNC_H
+#define INCLUDED_IEEE802154G_PREAMBLE_SYNC_H
+
+#include <gnuradio/block.h>
+#include <boost/atomic.hpp>
+#include "block_stats.h"
+#include "utils_mrfsk.h"
+
+#define NUM_MIDS        4
+#define FALSE_LOCK_WINDOWS      4       // lock lost within an octet
+
+namespace gr {
+  namespace ieee802154g {
+
+    /* lock counts of one preamble_sync */
+    struct preamble_sync_stats : public block_stats
+    {
+        boost::atomic<uint64_t> locks, false_locks;
+
+        preamble_sync_stats();
+        pmt::pmt_t to_pmt() const;
+    };
+
+    /*
+     * Preamble acquisition shared by preamble_detector and preamble_tracker,
+     * one 2-UI window of quad demod output at a time. While a 0xaa/0x55
+     * preamble lasts, the averaged zero crossings set the two sample points
+     * of the window and the mid level sets the frequency offset; after it
+     * they stay as they were. Locks are counted in stats().
+     */
+    class preamble_sync
+    {
+     private:
+        enum state_e { STATE_NONE, STATE_HAVE_PREAMBLE };
+        state_e state;
+
+        int sps;
+        float sps_half;
+        int sps_x2;
+
+        int s_tol;
+        int preamble_cnt;
+
+        /* of preamble_cnt: crossings averaged past avg_cnt, sample points
+         * follow past lock_cnt; drift_cnt off it when mid moves by
+         * freq_tol of peak to peak or more */
+        int avg_cnt;
+        int lock_cnt;
+        int drift_cnt;
+        float freq_tol;
+
+        int zcu_sum_cnt;
+        int zcd_sum_cnt;
+
+        float zcu_sum;
+        float zcd_sum;
+
+        float sample_point_a;
+        float sample_point_b;
+        /* output points as sample index and fraction for the interpolator */
+        int out_idx_a;
+        int out_idx_b;
+        float out_mu_a;
+        float out_mu_b;
+        bool points_set;        // by the last window
+
+        int prev_zcu_at;
+        int prev_zcd_at;
+
+        float crossing_at(const float *in, int at, float mid);
+
+        int dbg_num_zeros;
+
+        bool zcu_forced;
+        bool zcd_forced;
+
+        float mids[NUM_MIDS];
+        int mid_idx;
+        float mid_avg;
+        float get_mid(float a, float b);
+        float f_offset; // AFC
+
+        int locked_windows;     // 2-UI windows since lock
+        preamble_sync_stats d_stats;
+
+     public:
+        preamble_sync(int samples_per_symbol);
+
+        /* sps_x2 samples from in, in[-1] is read too; -1 on P_DEBUG failure */
+        int work_2ui(const float *in, const preamble_window_t &w);
+        /* as above, with the window's crossings of mid() already found */
+        int work_2ui(const float *in, const preamble_window_t &w,
+                int zcu_at, int zcd_at);
+        float mid() const { return mid_avg; }
+
+        /* std::out_of_range unless 1 <= avg <= lock, drift >= 0, tol > 0 */
+        void set_thresholds(int avg_windows, int lock_windows,
+                int drift_windows, float freq_tolerance);
+        int avg_windows() const { return avg_cnt; }
+        int lock_windows() const { return lock_cnt; }
+        int drift_windows() const { return drift_cnt; }
+        float freq_tolerance() const { return freq_tol; }
+
+        void set_out_points(float a, float b);
+        bool out_points_set() const { return points_set; }
+        float out_point_a() const { return out_idx_a + out_mu_a; }
+        float out_point_b() const { return out_idx_b + out_mu_b; }
+        float offset() const { return f_offset; }
+        bool squelched() const { return dbg_num_zeros == sps_x2; }
+
+        /* symbols at the output points of the window at in, less offset;
+         * reads in[-1] through in[sps_x2+1] */
+        float sample_a(const float *in) const
+        {
+            return farrow_cubic(&in[out_idx_a], out_mu_a) - f_offset;
+        }
+        float sample_b(const float *in) const
+        {
+            return farrow_cubic(&in[out_idx_b], out_mu_b) - f_offset;
+        }
+
+        preamble_sync_stats &stats() { return d_stats; }
+        uint64_t locks() const { return d_stats.locks; }
+        uint64_t false_locks() const { return d_stats.false_locks; }
+    };
+
+#ifdef GR_CTRLPORT
+    /* lock counts as ControlPort variables of a block with their getters */
+    template <class T>
+    void preamble_sync_rpc(T *block)
+    {
+        static const block_stats_var<T> vars[] = {
+            { "locks", &T::locks, "Preamble locks" },
+            { "false_locks", &T::false_locks, "Preamble locks lost within an octet" },
+        };
+
+        block_stats_rpc(block, vars);
+    }
+#endif /* GR_CTRLPORT */
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_PREAMBLE_SYNC_H */
@@ -0,0 +1,184 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "preamble_tracker_impl.h"
+#include <math.h>
+
+namespace gr {
+  namespace ieee802154g {
+
+    preamble_tracker::sptr
+    preamble_tracker::make(int samples_per_symbol, float loop_gain)
+    {
+      return gnuradio::get_initial_sptr
+        (new preamble_tracker_impl(samples_per_symbol, loop_gain));
+    }
+
+    /*
+     * The private constructor
+     */
+    preamble_tracker_impl::preamble_tracker_impl(int samples_per_symbol, float loop_gain)
+      : gr::block("preamble_tracker",
+              gr::io_signature::make(1, 1, sizeof(float)),
+              gr::io_signature::make(1, 1, sizeof(float))),
+        sps_x2(samples_per_symbol * 2),
+        d_lookbehind(samples_per_symbol + 2),
+        d_sync(samples_per_symbol),
+        d_gain(loop_gain),
+        d_prev(0), d_prev_at(0)
+    {
+        set_output_multiple(2);
+        set_relative_rate(1.0 / samples_per_symbol);
+        d_a = d_sync.out_point_a();
+        d_b = d_sync.out_point_b();
+
+        message_port_register_out(pmt::mp("stats"));
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    preamble_tracker_impl::~preamble_tracker_impl()
+    {
+    }
+
+    void
+    preamble_tracker_impl::set_loop_gain(float loop_gain)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        d_gain = loop_gain;
+    }
+
+    void
+    preamble_tracker_impl::set_stats_interval(double seconds)
+    {
+        gr::thread::scoped_lock guard(d_setlock);
+        d_sync.stats().set_interval(seconds);
+    }
+
+    void
+    preamble_tracker_impl::setup_rpc()
+    {
+#ifdef GR_CTRLPORT
+        preamble_sync_rpc(this);
+#endif /* GR_CTRLPORT */
+    }
+
+    void
+    preamble_tracker_impl::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+    {
+        /* windows may take one sample more each; interpolator reads two past */
+        ninput_items_required[0] = noutput_items / 2 * (sps_x2 + 1) + d_lookbehind + 2;
+    }
+
+    /* symbol at fractional index at of the window at in, less offset */
+    float
+    preamble_tracker_impl::sample(const float *in, float at) const
+    {
+        int n = (int)floorf(at);
+        return farrow_cubic(&in[n], at - n) - d_sync.offset();
+    }
+
+    /* Symbols y0, y1 at at0, at1: if they differ, samples late (positive) or
+     * early by where the signal midway between crosses zero, as a straight
+     * line through it from y0 to y1 would. */
+    float
+    preamble_tracker_impl::crossing_error(const float *in, float at0, float y0,
+            float at1, float y1) const
+    {
+        float mid = (at0 + at1) / 2;
+        float e;
+
+        if ((y0 < 0) == (y1 < 0) || mid < 1 - d_lookbehind)
+            return 0;
+        e = sample(in, mid) * (at1 - at0) / (y1 - y0);
+        return fmaxf(-sps_x2 / 4.0f, fminf(e, sps_x2 / 4.0f));
+    }
+
+    int
+    preamble_tracker_impl::general_work(int noutput_items,
+            gr_vector_int &ninput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items)
+    {
+        const float *in = (const float *) input_items[0];
+        float *out = (float *) output_items[0];
+        int pos = d_lookbehind;         // start of window
+        int i = 0;
+
+        gr::thread::scoped_lock guard(d_setlock);
+
+        while (i < noutput_items && pos + sps_x2 + 2 <= ninput_items[0]) {
+            const float *w = &in[pos];
+            preamble_window_t win;
+            int adv = sps_x2;
+
+            preamble_windows(&win, w, sps_x2, 1);
+            if (d_sync.work_2ui(w, win))
+                return -1;
+
+            float at_b = d_b;
+            if (d_sync.out_points_set()) {
+                /* preamble: sample points are as found on it */
+                d_a = d_sync.out_point_a();
+                d_b = at_b = d_sync.out_point_b();
+                out[i++] = sample(w, d_a);
+                out[i++] = d_prev = sample(w, d_b);
+            } else {
+                float ya = sample(w, d_a);
+                float yb = sample(w, d_b);
+                out[i++] = ya;
+                out[i++] = yb;
+                if (!d_sync.squelched()) {
+                    float e = crossing_error(w, d_prev_at, d_prev, d_a, ya) +
+                        crossing_error(w, d_a, ya, d_b, yb);
+                    d_a -= d_gain * e;
+                    d_b -= d_gain * e;
+                }
+                d_prev = yb;
+            }
+
+            /* sample points stay in the window: move the next window instead */
+            if (d_a < 0) {
+                adv--;
+                d_a++;
+                d_b++;
+            } else if (d_b >= sps_x2) {
+                adv++;
+                d_a--;
+                d_b--;
+            }
+            d_prev_at = at_b - adv;
+            pos += adv;
+        }
+
+        consume_each(pos - d_lookbehind);
+        d_sync.stats().poll(this);
+
+        return i;
+    }
+
+  } /* namespace ieee802154g */
+} /* namespace gr */
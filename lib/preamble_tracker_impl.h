@@ -0,0 +1,63 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_IEEE802154G_PREAMBLE_TRACKER_IMPL_H
+#define INCLUDED_IEEE802154G_PREAMBLE_TRACKER_IMPL_H
+
+#include <ieee802154g/preamble_tracker.h>
+#include "preamble_sync.h"
+
+namespace gr {
+  namespace ieee802154g {
+
+    class preamble_tracker_impl : public preamble_tracker
+    {
+     private:
+        int sps_x2;
+        int d_lookbehind;       // samples kept ahead of each window
+        preamble_sync d_sync;
+        float d_gain;
+        float d_a, d_b;         // sample points in the window, as tracked
+        float d_prev;           // last symbol out, b of the window before
+        float d_prev_at;        // where it was, from this window's start
+        float sample(const float *in, float at) const;
+        float crossing_error(const float *in, float at0, float y0, float at1, float y1) const;
+
+     public:
+      preamble_tracker_impl(int samples_per_symbol, float loop_gain);
+      ~preamble_tracker_impl();
+
+      void set_loop_gain(float loop_gain);
+      uint64_t locks() const { return d_sync.locks(); }
+      uint64_t false_locks() const { return d_sync.false_locks(); }
+      void set_stats_interval(double seconds);
+      void setup_rpc();
+
+      void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+      int general_work(int noutput_items,
+               gr_vector_int &ninput_items,
+               gr_vector_const_void_star &input_items,
+               gr_vector_void_star &output_items);
+    };
+
+  } // namespace ieee802154g
+} // namespace gr
+
+#endif /* INCLUDED_IEEE802154G_PREAMBLE_TRACKER_IMPL_H */
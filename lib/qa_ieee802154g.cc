@@ -26,11 +26,13 @@
  */
 
 #include "qa_ieee802154g.h"
+#include "qa_utils_mrfsk.h"
 
 CppUnit::TestSuite *
 qa_ieee802154g::suite()
 {
   CppUnit::TestSuite *s = new CppUnit::TestSuite("ieee802154g");
+  s->addTest(qa_utils_mrfsk::suite());
 
   return s;
 }
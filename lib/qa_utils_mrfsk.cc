@@ -0,0 +1,395 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "qa_utils_mrfsk.h"
+#include "utils_mrfsk.h"
+#include "preamble_scan.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* bit-at-a-time reference */
+static uint16_t
+crc16_bitwise(uint16_t crc, const uint8_t *p, int len)
+{
+    while (len--) {
+        crc ^= (uint16_t)*p++ << 8;
+        for (int i = 0; i < 8; i++)
+            crc = (crc << 1) ^ ((crc & 0x8000) ? 0x1021 : 0);
+    }
+    return crc;
+}
+
+static uint32_t
+crc32_bitwise(uint32_t crc, const uint8_t *p, int len)
+{
+    while (len--) {
+        crc ^= (uint32_t)*p++ << 24;
+        for (int i = 0; i < 8; i++)
+            crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04c11db7 : 0);
+    }
+    return crc;
+}
+
+/* bit-at-a-time PN9 LFSR, x^9 + x^5 + 1 */
+static uint8_t
+pn9_bitwise(uint16_t *lfsr)
+{
+    uint8_t ret = 0;
+    for (uint8_t bp = 0x80; bp > 0; bp >>= 1) {
+        int xor_out = ((*lfsr >> 5) & 1) ^ (*lfsr & 1);
+        *lfsr = (*lfsr >> 1) | (xor_out << 8);
+        if (*lfsr & 0x100)
+            ret |= bp;
+    }
+    return ret;
+}
+
+/* preamble_detector's original per-sample scan of one window */
+static void
+preamble_window_ref(preamble_window_t *o, const float *in, int len, float mid, int first,
+    int *zcu_at, int *zcd_at)
+{
+    o->min_val = PREAMBLE_WINDOW_MIN;
+    o->max_val = PREAMBLE_WINDOW_MAX;
+    o->min_at = o->max_at = -1;
+    *zcu_at = *zcd_at = -1;
+    int zeros = 0;
+    for (int n = 0; n < len; n++) {
+        if (in[n] == 0)
+            zeros++;
+        if (in[n] < o->min_val) {
+            o->min_val = in[n];
+            o->min_at = n;
+        }
+        if (in[n] > o->max_val) {
+            o->max_val = in[n];
+            o->max_at = n;
+        }
+        if (!first || n > 0) {
+            if (in[n-1] < mid && in[n] >= mid)
+                *zcu_at = n;
+            else if (in[n-1] >= mid && in[n] < mid)
+                *zcd_at = n;
+        }
+    }
+    o->zeros = zeros == len;
+}
+
+#ifdef HAVE_PREAMBLE_SCAN
+/* fixed-length scan of windows as t7 makes them, against the reference */
+template <int LEN>
+static void
+check_preamble_scan()
+{
+    static float buf[1 + 8 * LEN];
+    preamble_window_t w, ref;
+    int zcu, zcd, ref_zcu, ref_zcd;
+
+    for (int rep = 0; rep < 50; rep++) {
+        for (int i = 0; i < 1 + 8 * LEN; i++) {
+            int r = rand() % 64;
+            buf[i] = r < 4 ? 0 : r < 8 ? 0.25f : r == 8 ? NAN :
+                0.1f * sinf(i * 0.4f) + (rand() % 100) * 1e-3f - 0.05f;
+        }
+        if (rep % 5 == 0)
+            memset(buf + 1 + 3 * LEN, 0, LEN * sizeof(float));     // squelched
+        for (int k = 0; k < 8; k++) {
+            const float *in = buf + 1 + k * LEN;
+            float mid = (k - 4) * 0.01f;
+            preamble_window_ref(&ref, in, LEN, mid, 0, &ref_zcu, &ref_zcd);
+            gr::ieee802154g::preamble_scan<LEN>(in, mid, &w, &zcu, &zcd);
+            CPPUNIT_ASSERT_EQUAL(ref_zcu, zcu);
+            CPPUNIT_ASSERT_EQUAL(ref_zcd, zcd);
+            CPPUNIT_ASSERT_EQUAL(ref.zeros, w.zeros);
+            CPPUNIT_ASSERT_EQUAL(ref.min_at, w.min_at);
+            CPPUNIT_ASSERT_EQUAL(ref.max_at, w.max_at);
+            CPPUNIT_ASSERT(memcmp(&ref.min_val, &w.min_val, sizeof(float)) == 0);
+            CPPUNIT_ASSERT(memcmp(&ref.max_val, &w.max_val, sizeof(float)) == 0);
+        }
+    }
+}
+#endif /* HAVE_PREAMBLE_SCAN */
+
+/* bit-at-a-time NRNSC, Figure 124: returns coded bit count written MSbit first */
+static int
+nrnsc_bitwise(uint8_t *out, const uint8_t *in, int nbits, int *m)
+{
+    int n = 0;
+    for (int i = 0; i < nbits; i++) {
+        int b = (in[i >> 3] >> (7 - (i & 7))) & 1;
+        int ui1 = b ^ m[1] ^ m[2];
+        int ui0 = b ^ m[0] ^ m[1] ^ m[2];
+        m[2] = m[1];
+        m[1] = m[0];
+        m[0] = b;
+        for (int u = 0; u < 2; u++, n++) {
+            if (!(u ? ui0 : ui1))   // inverted over the air
+                out[n >> 3] |= 0x80 >> (n & 7);
+            else
+                out[n >> 3] &= ~(0x80 >> (n & 7));
+        }
+    }
+    return n;
+}
+
+void
+qa_utils_mrfsk::t1_crc16()
+{
+    // CRC-16 test from section 5.2.1.9 in 802.15.4-2011
+    const uint8_t psdu[] = { 0x40, 0x00, 0x56, 0x27, 0x9e };
+    CPPUNIT_ASSERT_EQUAL((uint16_t)0x279e, crc_msb_first(INITIAL_CRC16, psdu, 3));
+    CPPUNIT_ASSERT_EQUAL((uint16_t)0x0000, crc_msb_first(INITIAL_CRC16, psdu, 5));
+
+    uint8_t buf[aMaxPHYPacketSize];
+    srand(1);
+    for (int i = 0; i < aMaxPHYPacketSize; i++)
+        buf[i] = rand();
+
+    for (int len = 0; len < aMaxPHYPacketSize; len += 37) {
+        uint16_t crc = INITIAL_CRC16;
+        for (int i = 0; i < len; i++)
+            crc = crc_msb_first_byte(crc, buf[i]);
+        CPPUNIT_ASSERT_EQUAL(crc16_bitwise(INITIAL_CRC16, buf, len), crc);
+        CPPUNIT_ASSERT_EQUAL(crc, crc_msb_first(INITIAL_CRC16, buf, len));
+        // unaligned start
+        CPPUNIT_ASSERT_EQUAL(crc16_bitwise(0x1234, buf+1, len-1 > 0 ? len-1 : 0),
+                             crc_msb_first(0x1234, buf+1, len-1 > 0 ? len-1 : 0));
+    }
+}
+
+void
+qa_utils_mrfsk::t2_crc32()
+{
+    // CRC-32 test from section 5.2.1.9 in 802.15.4g-2012 (zero padded to 4 octets)
+    const uint8_t psdu[] = { 0x40, 0x00, 0x56, 0x00 };
+    CPPUNIT_ASSERT_EQUAL((uint32_t)0x5d29fa28, (uint32_t)~digital_update_crc32(INITIAL_CRC32, psdu, 4));
+
+    // long enough to take carry-less multiply path, when CPU has it
+    uint8_t buf[aMaxPHYPacketSize];
+    srand(2);
+    for (int i = 0; i < aMaxPHYPacketSize; i++)
+        buf[i] = rand();
+
+    for (int len = 0; len < aMaxPHYPacketSize; len += 29) {
+        CPPUNIT_ASSERT_EQUAL(crc32_bitwise(INITIAL_CRC32, buf, len),
+                             (uint32_t)digital_update_crc32(INITIAL_CRC32, buf, len));
+        CPPUNIT_ASSERT_EQUAL(crc32_bitwise(0x12345678, buf+3, len-3 > 0 ? len-3 : 0),
+                             (uint32_t)digital_update_crc32(0x12345678, buf+3, len-3 > 0 ? len-3 : 0));
+    }
+}
+
+void
+qa_utils_mrfsk::t3_pn9()
+{
+    uint8_t buf[aMaxPHYPacketSize], expected[aMaxPHYPacketSize];
+    uint16_t ref, lfsr;
+
+    // every state, across the period wrap
+    for (int state = 1; state < 512; state++) {
+        ref = lfsr = state;
+        for (int i = 0; i < PN9_PERIOD + 8; i++) {
+            CPPUNIT_ASSERT_EQUAL(pn9_bitwise(&ref), get_pn9_byte(&lfsr));
+            CPPUNIT_ASSERT_EQUAL(ref, lfsr);
+        }
+    }
+
+    srand(3);
+    for (int len = 1; len < aMaxPHYPacketSize; len += 41) {
+        ref = lfsr = 1 + rand() % 511;
+        for (int i = 0; i < len; i++) {
+            buf[i] = rand();
+            expected[i] = buf[i] ^ pn9_bitwise(&ref);
+        }
+        pn9_xor(buf, len, &lfsr);
+        CPPUNIT_ASSERT(memcmp(expected, buf, len) == 0);
+        CPPUNIT_ASSERT_EQUAL(ref, lfsr);
+    }
+}
+
+void
+qa_utils_mrfsk::t4_interleave()
+{
+    uint8_t buf[4*1024], expected[4*1024];
+
+    srand(4);
+    for (int len = 0; len <= (int)sizeof(buf); len += 4*37) {
+        for (int i = 0; i < len; i++)
+            buf[i] = expected[i] = rand();
+
+        // word and whole frame must agree with interleave() on every block
+        for (int i = 0; i < len; i += 4) {
+            uint32_t w = buf[i] << 24 | buf[i+1] << 16 | buf[i+2] << 8 | buf[i+3];
+            interleave(&expected[i]);
+            interleave_u32(&w);
+            CPPUNIT_ASSERT_EQUAL((uint32_t)(expected[i] << 24 | expected[i+1] << 16 | expected[i+2] << 8 | expected[i+3]), w);
+        }
+        interleave_frame(buf, len);
+        CPPUNIT_ASSERT(memcmp(expected, buf, len) == 0);
+
+        // deinterleave is the same permutation
+        for (int i = 0; i < len; i += 4)
+            interleave(&expected[i]);
+        interleave_frame(buf, len);
+        CPPUNIT_ASSERT(memcmp(expected, buf, len) == 0);
+    }
+}
+
+void
+qa_utils_mrfsk::t5_nrnsc()
+{
+    // Annex O.3 of 802.15.4g-2012: PHR + PSDU 0x400056 with 32bit FCS, coded and interleaved
+    const uint8_t phr_psdu[] = { 0x00, 0x07, 0x40, 0x00, 0x56, 0x5d, 0x29, 0xfa, 0x28 };
+    const uint8_t annex_o[] = {
+        0xbf, 0x7f, 0x3f, 0xff, 0xfc, 0xfd, 0xfc, 0xf2, 0x37, 0xaa,
+        0xbc, 0xb7, 0x5e, 0x13, 0xa4, 0x5d, 0xb2, 0xf0, 0xb4, 0x3c
+    };
+    uint8_t buf[2*(PHR_LENGTH+aMaxPHYPacketSize)+4], expected[sizeof(buf)];
+    uint8_t in[PHR_LENGTH+aMaxPHYPacketSize];
+    size_t len;
+
+    len = 2*sizeof(phr_psdu);
+    len += nrnsc_encode_tail(&buf[len], sizeof(phr_psdu),
+        nrnsc_encode(buf, phr_psdu, sizeof(phr_psdu), NRNSC_STATE_INIT));
+    CPPUNIT_ASSERT_EQUAL(sizeof(annex_o), len);
+    interleave_frame(buf, len);
+    CPPUNIT_ASSERT(memcmp(annex_o, buf, len) == 0);
+
+    // tail 000 then pad 01011 (odd length) or 0101100001011 (even length)
+    const uint8_t tail_pad[] = { 0x0b, 0x0b };
+    srand(5);
+    for (int n = 1; n < (int)sizeof(in); n += 43) {
+        int m[3] = { 0, 0, 0 }, nbits;
+        for (int i = 0; i < n; i++)
+            in[i] = rand();
+        nbits = nrnsc_bitwise(expected, in, n*8, m);
+        nbits += nrnsc_bitwise(&expected[nbits/8], tail_pad, (n & 1) ? 8 : 16, m);
+
+        uint8_t state = nrnsc_encode(buf, in, n, NRNSC_STATE_INIT);
+        len = 2*n + nrnsc_encode_tail(&buf[2*n], n, state);
+        CPPUNIT_ASSERT_EQUAL((size_t)nbits/8, len);
+        CPPUNIT_ASSERT_EQUAL(0, (int)len % 4);
+        CPPUNIT_ASSERT(memcmp(expected, buf, len) == 0);
+    }
+}
+
+void
+qa_utils_mrfsk::t6_viterbi()
+{
+    uint8_t in[PHR_LENGTH+aMaxPHYPacketSize], coded[2*sizeof(in)+4], out[sizeof(in)+2];
+    static int8_t soft[8*sizeof(coded)], block[32];
+    static uint8_t decisions[8*sizeof(out)];
+    int16_t metric[NRNSC_STATES];
+
+    srand(6);
+    for (int n = 1; n < (int)sizeof(in); n += 97) {
+        for (int i = 0; i < n; i++)
+            in[i] = rand();
+        uint8_t state = nrnsc_encode(coded, in, n, NRNSC_STATE_INIT);
+        size_t len = 2*n + nrnsc_encode_tail(&coded[2*n], n, state);
+        interleave_frame(coded, len);
+
+        // over the air as soft bits, every 13th wrong but weak
+        for (size_t i = 0; i < 8*len; i++) {
+            int8_t v = (coded[i/8] >> (7 - i%8)) & 1 ? 100 : -100;
+            block[i%32] = i % 13 == 5 ? -v/4 : v;
+            if (i % 32 == 31)
+                deinterleave_soft(&soft[i-31], block);
+        }
+        nrnsc_viterbi_init(metric, NRNSC_STATE_INIT);
+        nrnsc_viterbi_acs(metric, decisions, soft, 4*len);
+        nrnsc_viterbi_traceback(out, decisions, 4*len, NRNSC_STATE_END);
+        CPPUNIT_ASSERT(memcmp(in, out, n) == 0);
+        CPPUNIT_ASSERT_EQUAL((int)NRNSC_STATE_END, (int)nrnsc_viterbi_best(metric));
+    }
+}
+
+void
+qa_utils_mrfsk::t7_preamble_windows()
+{
+    static float buf[1 + 8 * 150];
+    preamble_window_t w[8], ref;
+    int zcu, zcd, ref_zcu, ref_zcd;
+
+    srand(7);
+    for (int len = 1; len <= 150; len++) {
+        for (int i = 0; i < 1 + 8 * len; i++) {
+            int r = rand() % 64;
+            /* ties, zeros, a NaN now and then; slow swings so mid is crossed */
+            buf[i] = r < 4 ? 0 : r < 8 ? 0.25f : r == 8 ? NAN :
+                0.1f * sinf(i * 0.4f) + (rand() % 100) * 1e-3f - 0.05f;
+        }
+        if (len % 5 == 0)
+            memset(buf + 1 + 3 * len, 0, len * sizeof(float));     // squelched
+        preamble_windows(w, buf + 1, len, 8);
+        for (int k = 0; k < 8; k++) {
+            const float *in = buf + 1 + k * len;
+            float mid = (k - 4) * 0.01f;
+            for (int first = 0; first < 2; first++) {
+                preamble_window_ref(&ref, in, len, mid, first, &ref_zcu, &ref_zcd);
+                preamble_crossings(in, len, mid, first, &zcu, &zcd);
+                CPPUNIT_ASSERT_EQUAL(ref_zcu, zcu);
+                CPPUNIT_ASSERT_EQUAL(ref_zcd, zcd);
+            }
+            CPPUNIT_ASSERT_EQUAL(ref.zeros, w[k].zeros);
+            CPPUNIT_ASSERT_EQUAL(ref.min_at, w[k].min_at);
+            CPPUNIT_ASSERT_EQUAL(ref.max_at, w[k].max_at);
+            CPPUNIT_ASSERT(memcmp(&ref.min_val, &w[k].min_val, sizeof(float)) == 0);
+            CPPUNIT_ASSERT(memcmp(&ref.max_val, &w[k].max_val, sizeof(float)) == 0);
+        }
+    }
+}
+
+void
+qa_utils_mrfsk::t8_farrow_cubic()
+{
+    float x[4];
+
+    /* exact on the samples and for any cubic in between */
+    for (int i = 0; i < 4; i++)
+        x[i] = 0.5f * (i - 1) * (i - 1) * (i - 1) - (i - 1) * (i - 1) + 0.25f * (i - 1) + 3;
+    CPPUNIT_ASSERT_EQUAL(x[1], farrow_cubic(x + 1, 0));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(x[2], farrow_cubic(x + 1, 1), 1e-5);
+    for (int k = 0; k < 16; k++) {
+        float t = k / 16.0f;
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5f * t * t * t - t * t + 0.25f * t + 3,
+            farrow_cubic(x + 1, t), 1e-5);
+    }
+
+    /* half way across the 4 samples of a sinusoid's period */
+    x[0] = -1; x[1] = 1; x[2] = 1; x[3] = -1;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.25, farrow_cubic(x + 1, 0.5f), 1e-6);
+}
+
+void
+qa_utils_mrfsk::t9_preamble_scan()
+{
+#ifdef HAVE_PREAMBLE_SCAN
+    if (!cpu_has_avx2())
+        return;
+    srand(9);
+    /* 2 * samples per symbol of preamble_detector_impl<SPS> */
+    check_preamble_scan<8>();
+    check_preamble_scan<10>();
+    check_preamble_scan<16>();
+    check_preamble_scan<20>();
+    check_preamble_scan<32>();
+#endif /* HAVE_PREAMBLE_SCAN */
+}
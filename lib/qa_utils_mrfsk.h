@@ -0,0 +1,53 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2013 wroberts92780@gmail.com
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_UTILS_MRFSK_H_
+#define _QA_UTILS_MRFSK_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+class qa_utils_mrfsk : public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(qa_utils_mrfsk);
+  CPPUNIT_TEST(t1_crc16);
+  CPPUNIT_TEST(t2_crc32);
+  CPPUNIT_TEST(t3_pn9);
+  CPPUNIT_TEST(t4_interleave);
+  CPPUNIT_TEST(t5_nrnsc);
+  CPPUNIT_TEST(t6_viterbi);
+  CPPUNIT_TEST(t7_preamble_windows);
+  CPPUNIT_TEST(t8_farrow_cubic);
+  CPPUNIT_TEST(t9_preamble_scan);
+  CPPUNIT_TEST_SUITE_END();
+
+ private:
+  void t1_crc16();
+  void t2_crc32();
+  void t3_pn9();
+  void t4_interleave();
+  void t5_nrnsc();
+  void t6_viterbi();
+  void t7_preamble_windows();
+  void t8_farrow_cubic();
+  void t9_preamble_scan();
+};
+
+#endif /* _QA_UTILS_MRFSK_H_ */
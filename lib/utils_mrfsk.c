@@ -19,14 +19,61 @@
  */
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "utils_mrfsk.h"
 
-#define POLY_ITUT       0x1021  // msbit first poly crc16
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HAVE_X86_DISPATCH 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#ifdef HAVE_X86_DISPATCH
+#define CPU_CLMUL       0x01    // PCLMULQDQ + SSSE3
+#define CPU_BMI2        0x02    // PDEP/PEXT
+#define CPU_AVX2        0x04    // AVX2 + BMI1, and OS saves YMM state
+
+/* CPU features are probed once, on first use */
+static unsigned int
+cpu_features(void)
+{
+    static int features = -1;
+    unsigned int eax, ebx, ecx, edx;
+
+    if (features < 0) {
+        unsigned int f = 0;
+        int ymm = 0;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            if ((ecx & bit_PCLMUL) && (ecx & bit_SSSE3))
+                f |= CPU_CLMUL;
+            if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX)) {
+                __asm__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+                ymm = (eax & 6) == 6;   // XMM and YMM state enabled
+            }
+        }
+        if (__get_cpuid_max(0, NULL) >= 7) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            if (ebx & bit_BMI2)
+                f |= CPU_BMI2;
+            if (ymm && (ebx & bit_AVX2) && (ebx & bit_BMI))
+                f |= CPU_AVX2;
+        }
+        features = f;
+    }
+
+    return features;
+}
+#endif /* HAVE_X86_DISPATCH */
 
 /* section 5.2.1.9 specifies ANSI X3.66-1979 */
 // Automatically generated CRC function
 // polynomial: 0x104C11DB7
-unsigned int digital_update_crc32(unsigned int crc, const unsigned char *data, size_t len)
+static unsigned int
+crc32_table_update(unsigned int crc, const unsigned char *data, size_t len)
 {
     static const unsigned int table[256] = {
     0x00000000U,0x04C11DB7U,0x09823B6EU,0x0D4326D9U,
@@ -104,48 +151,305 @@ unsigned int digital_update_crc32(unsigned int crc, const unsigned char *data, s
     return crc;
 }
 
+#ifdef HAVE_X86_DISPATCH
+/* Below this the table is as fast as setting up the folding */
+#define CRC32_FOLD_MIN      128
+
+/* x^n mod P(x) folding constants: { x^d, x^(d+64) } for distance d */
+#define CRC32_K_512         0xe6228b11
+#define CRC32_K_576         0x8833794c
+#define CRC32_K_128         0xe8a45605
+#define CRC32_K_192         0xc5b9cd4c
+
+/* multiply both halves of x by x^d, reduced to 96 bits, and add to y */
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i
+crc32_fold(__m128i x, __m128i k, __m128i y)
+{
+    __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+    __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+    return _mm_xor_si128(y, _mm_xor_si128(hi, lo));
+}
+
+/* Carry-less multiply folding, 64 octets per iteration.
+ * Registers are kept msbit first (octet-swapped) to match this non-reflected CRC.
+ * The folded 128 bit remainder and the tail are finished with the table. */
+__attribute__((target("pclmul,ssse3")))
+static unsigned int
+crc32_clmul_update(unsigned int crc, const unsigned char *data, size_t len)
+{
+    const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i k512 = _mm_set_epi64x(CRC32_K_576, CRC32_K_512);
+    const __m128i k128 = _mm_set_epi64x(CRC32_K_192, CRC32_K_128);
+    __m128i x0, x1, x2, x3;
+    uint8_t rem[16];
+
+    x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), bswap);
+    x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+    x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+    x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+    /* CRC register is added to first 32 bits of message */
+    x0 = _mm_xor_si128(x0, _mm_set_epi32(crc, 0, 0, 0));
+    data += 64;
+    len -= 64;
+
+    while (len >= 64) {
+        x0 = crc32_fold(x0, k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), bswap));
+        x1 = crc32_fold(x1, k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap));
+        x2 = crc32_fold(x2, k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap));
+        x3 = crc32_fold(x3, k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap));
+        data += 64;
+        len -= 64;
+    }
+
+    /* four lanes down to one */
+    x1 = crc32_fold(x0, k128, x1);
+    x2 = crc32_fold(x1, k128, x2);
+    x0 = crc32_fold(x2, k128, x3);
+
+    while (len >= 16) {
+        x0 = crc32_fold(x0, k128, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), bswap));
+        data += 16;
+        len -= 16;
+    }
+
+    _mm_storeu_si128((__m128i *)rem, _mm_shuffle_epi8(x0, bswap));
+    crc = crc32_table_update(0, rem, sizeof(rem));
+
+    return crc32_table_update(crc, data, len);
+}
+#endif /* HAVE_X86_DISPATCH */
+
+/* Same calling convention as gr-digital digital_update_crc32(), but msbit first.
+ * Uses carry-less multiply when CPU supports it. */
+unsigned int
+digital_update_crc32(unsigned int crc, const unsigned char *data, size_t len)
+{
+#ifdef HAVE_X86_DISPATCH
+    if (len >= CRC32_FOLD_MIN && (cpu_features() & CPU_CLMUL))
+        return crc32_clmul_update(crc, data, len);
+#endif
+    return crc32_table_update(crc, data, len);
+}
+
 /* Section 5.2.1.9 specifies 16bit ITU-T CRC */
+// Automatically generated CRC tables, slice-by-4
+// polynomial: 0x11021 (ITU-T), msbit first
+// crc16_table[k][b] is CRC of octet b followed by k zero octets
+const uint16_t crc16_table[4][256] = {
+    {
+    0x0000,0x1021,0x2042,0x3063,0x4084,0x50A5,0x60C6,0x70E7,
+    0x8108,0x9129,0xA14A,0xB16B,0xC18C,0xD1AD,0xE1CE,0xF1EF,
+    0x1231,0x0210,0x3273,0x2252,0x52B5,0x4294,0x72F7,0x62D6,
+    0x9339,0x8318,0xB37B,0xA35A,0xD3BD,0xC39C,0xF3FF,0xE3DE,
+    0x2462,0x3443,0x0420,0x1401,0x64E6,0x74C7,0x44A4,0x5485,
+    0xA56A,0xB54B,0x8528,0x9509,0xE5EE,0xF5CF,0xC5AC,0xD58D,
+    0x3653,0x2672,0x1611,0x0630,0x76D7,0x66F6,0x5695,0x46B4,
+    0xB75B,0xA77A,0x9719,0x8738,0xF7DF,0xE7FE,0xD79D,0xC7BC,
+    0x48C4,0x58E5,0x6886,0x78A7,0x0840,0x1861,0x2802,0x3823,
+    0xC9CC,0xD9ED,0xE98E,0xF9AF,0x8948,0x9969,0xA90A,0xB92B,
+    0x5AF5,0x4AD4,0x7AB7,0x6A96,0x1A71,0x0A50,0x3A33,0x2A12,
+    0xDBFD,0xCBDC,0xFBBF,0xEB9E,0x9B79,0x8B58,0xBB3B,0xAB1A,
+    0x6CA6,0x7C87,0x4CE4,0x5CC5,0x2C22,0x3C03,0x0C60,0x1C41,
+    0xEDAE,0xFD8F,0xCDEC,0xDDCD,0xAD2A,0xBD0B,0x8D68,0x9D49,
+    0x7E97,0x6EB6,0x5ED5,0x4EF4,0x3E13,0x2E32,0x1E51,0x0E70,
+    0xFF9F,0xEFBE,0xDFDD,0xCFFC,0xBF1B,0xAF3A,0x9F59,0x8F78,
+    0x9188,0x81A9,0xB1CA,0xA1EB,0xD10C,0xC12D,0xF14E,0xE16F,
+    0x1080,0x00A1,0x30C2,0x20E3,0x5004,0x4025,0x7046,0x6067,
+    0x83B9,0x9398,0xA3FB,0xB3DA,0xC33D,0xD31C,0xE37F,0xF35E,
+    0x02B1,0x1290,0x22F3,0x32D2,0x4235,0x5214,0x6277,0x7256,
+    0xB5EA,0xA5CB,0x95A8,0x8589,0xF56E,0xE54F,0xD52C,0xC50D,
+    0x34E2,0x24C3,0x14A0,0x0481,0x7466,0x6447,0x5424,0x4405,
+    0xA7DB,0xB7FA,0x8799,0x97B8,0xE75F,0xF77E,0xC71D,0xD73C,
+    0x26D3,0x36F2,0x0691,0x16B0,0x6657,0x7676,0x4615,0x5634,
+    0xD94C,0xC96D,0xF90E,0xE92F,0x99C8,0x89E9,0xB98A,0xA9AB,
+    0x5844,0x4865,0x7806,0x6827,0x18C0,0x08E1,0x3882,0x28A3,
+    0xCB7D,0xDB5C,0xEB3F,0xFB1E,0x8BF9,0x9BD8,0xABBB,0xBB9A,
+    0x4A75,0x5A54,0x6A37,0x7A16,0x0AF1,0x1AD0,0x2AB3,0x3A92,
+    0xFD2E,0xED0F,0xDD6C,0xCD4D,0xBDAA,0xAD8B,0x9DE8,0x8DC9,
+    0x7C26,0x6C07,0x5C64,0x4C45,0x3CA2,0x2C83,0x1CE0,0x0CC1,
+    0xEF1F,0xFF3E,0xCF5D,0xDF7C,0xAF9B,0xBFBA,0x8FD9,0x9FF8,
+    0x6E17,0x7E36,0x4E55,0x5E74,0x2E93,0x3EB2,0x0ED1,0x1EF0,
+    },
+    {
+    0x0000,0x3331,0x6662,0x5553,0xCCC4,0xFFF5,0xAAA6,0x9997,
+    0x89A9,0xBA98,0xEFCB,0xDCFA,0x456D,0x765C,0x230F,0x103E,
+    0x0373,0x3042,0x6511,0x5620,0xCFB7,0xFC86,0xA9D5,0x9AE4,
+    0x8ADA,0xB9EB,0xECB8,0xDF89,0x461E,0x752F,0x207C,0x134D,
+    0x06E6,0x35D7,0x6084,0x53B5,0xCA22,0xF913,0xAC40,0x9F71,
+    0x8F4F,0xBC7E,0xE92D,0xDA1C,0x438B,0x70BA,0x25E9,0x16D8,
+    0x0595,0x36A4,0x63F7,0x50C6,0xC951,0xFA60,0xAF33,0x9C02,
+    0x8C3C,0xBF0D,0xEA5E,0xD96F,0x40F8,0x73C9,0x269A,0x15AB,
+    0x0DCC,0x3EFD,0x6BAE,0x589F,0xC108,0xF239,0xA76A,0x945B,
+    0x8465,0xB754,0xE207,0xD136,0x48A1,0x7B90,0x2EC3,0x1DF2,
+    0x0EBF,0x3D8E,0x68DD,0x5BEC,0xC27B,0xF14A,0xA419,0x9728,
+    0x8716,0xB427,0xE174,0xD245,0x4BD2,0x78E3,0x2DB0,0x1E81,
+    0x0B2A,0x381B,0x6D48,0x5E79,0xC7EE,0xF4DF,0xA18C,0x92BD,
+    0x8283,0xB1B2,0xE4E1,0xD7D0,0x4E47,0x7D76,0x2825,0x1B14,
+    0x0859,0x3B68,0x6E3B,0x5D0A,0xC49D,0xF7AC,0xA2FF,0x91CE,
+    0x81F0,0xB2C1,0xE792,0xD4A3,0x4D34,0x7E05,0x2B56,0x1867,
+    0x1B98,0x28A9,0x7DFA,0x4ECB,0xD75C,0xE46D,0xB13E,0x820F,
+    0x9231,0xA100,0xF453,0xC762,0x5EF5,0x6DC4,0x3897,0x0BA6,
+    0x18EB,0x2BDA,0x7E89,0x4DB8,0xD42F,0xE71E,0xB24D,0x817C,
+    0x9142,0xA273,0xF720,0xC411,0x5D86,0x6EB7,0x3BE4,0x08D5,
+    0x1D7E,0x2E4F,0x7B1C,0x482D,0xD1BA,0xE28B,0xB7D8,0x84E9,
+    0x94D7,0xA7E6,0xF2B5,0xC184,0x5813,0x6B22,0x3E71,0x0D40,
+    0x1E0D,0x2D3C,0x786F,0x4B5E,0xD2C9,0xE1F8,0xB4AB,0x879A,
+    0x97A4,0xA495,0xF1C6,0xC2F7,0x5B60,0x6851,0x3D02,0x0E33,
+    0x1654,0x2565,0x7036,0x4307,0xDA90,0xE9A1,0xBCF2,0x8FC3,
+    0x9FFD,0xACCC,0xF99F,0xCAAE,0x5339,0x6008,0x355B,0x066A,
+    0x1527,0x2616,0x7345,0x4074,0xD9E3,0xEAD2,0xBF81,0x8CB0,
+    0x9C8E,0xAFBF,0xFAEC,0xC9DD,0x504A,0x637B,0x3628,0x0519,
+    0x10B2,0x2383,0x76D0,0x45E1,0xDC76,0xEF47,0xBA14,0x8925,
+    0x991B,0xAA2A,0xFF79,0xCC48,0x55DF,0x66EE,0x33BD,0x008C,
+    0x13C1,0x20F0,0x75A3,0x4692,0xDF05,0xEC34,0xB967,0x8A56,
+    0x9A68,0xA959,0xFC0A,0xCF3B,0x56AC,0x659D,0x30CE,0x03FF,
+    },
+    {
+    0x0000,0x3730,0x6E60,0x5950,0xDCC0,0xEBF0,0xB2A0,0x8590,
+    0xA9A1,0x9E91,0xC7C1,0xF0F1,0x7561,0x4251,0x1B01,0x2C31,
+    0x4363,0x7453,0x2D03,0x1A33,0x9FA3,0xA893,0xF1C3,0xC6F3,
+    0xEAC2,0xDDF2,0x84A2,0xB392,0x3602,0x0132,0x5862,0x6F52,
+    0x86C6,0xB1F6,0xE8A6,0xDF96,0x5A06,0x6D36,0x3466,0x0356,
+    0x2F67,0x1857,0x4107,0x7637,0xF3A7,0xC497,0x9DC7,0xAAF7,
+    0xC5A5,0xF295,0xABC5,0x9CF5,0x1965,0x2E55,0x7705,0x4035,
+    0x6C04,0x5B34,0x0264,0x3554,0xB0C4,0x87F4,0xDEA4,0xE994,
+    0x1DAD,0x2A9D,0x73CD,0x44FD,0xC16D,0xF65D,0xAF0D,0x983D,
+    0xB40C,0x833C,0xDA6C,0xED5C,0x68CC,0x5FFC,0x06AC,0x319C,
+    0x5ECE,0x69FE,0x30AE,0x079E,0x820E,0xB53E,0xEC6E,0xDB5E,
+    0xF76F,0xC05F,0x990F,0xAE3F,0x2BAF,0x1C9F,0x45CF,0x72FF,
+    0x9B6B,0xAC5B,0xF50B,0xC23B,0x47AB,0x709B,0x29CB,0x1EFB,
+    0x32CA,0x05FA,0x5CAA,0x6B9A,0xEE0A,0xD93A,0x806A,0xB75A,
+    0xD808,0xEF38,0xB668,0x8158,0x04C8,0x33F8,0x6AA8,0x5D98,
+    0x71A9,0x4699,0x1FC9,0x28F9,0xAD69,0x9A59,0xC309,0xF439,
+    0x3B5A,0x0C6A,0x553A,0x620A,0xE79A,0xD0AA,0x89FA,0xBECA,
+    0x92FB,0xA5CB,0xFC9B,0xCBAB,0x4E3B,0x790B,0x205B,0x176B,
+    0x7839,0x4F09,0x1659,0x2169,0xA4F9,0x93C9,0xCA99,0xFDA9,
+    0xD198,0xE6A8,0xBFF8,0x88C8,0x0D58,0x3A68,0x6338,0x5408,
+    0xBD9C,0x8AAC,0xD3FC,0xE4CC,0x615C,0x566C,0x0F3C,0x380C,
+    0x143D,0x230D,0x7A5D,0x4D6D,0xC8FD,0xFFCD,0xA69D,0x91AD,
+    0xFEFF,0xC9CF,0x909F,0xA7AF,0x223F,0x150F,0x4C5F,0x7B6F,
+    0x575E,0x606E,0x393E,0x0E0E,0x8B9E,0xBCAE,0xE5FE,0xD2CE,
+    0x26F7,0x11C7,0x4897,0x7FA7,0xFA37,0xCD07,0x9457,0xA367,
+    0x8F56,0xB866,0xE136,0xD606,0x5396,0x64A6,0x3DF6,0x0AC6,
+    0x6594,0x52A4,0x0BF4,0x3CC4,0xB954,0x8E64,0xD734,0xE004,
+    0xCC35,0xFB05,0xA255,0x9565,0x10F5,0x27C5,0x7E95,0x49A5,
+    0xA031,0x9701,0xCE51,0xF961,0x7CF1,0x4BC1,0x1291,0x25A1,
+    0x0990,0x3EA0,0x67F0,0x50C0,0xD550,0xE260,0xBB30,0x8C00,
+    0xE352,0xD462,0x8D32,0xBA02,0x3F92,0x08A2,0x51F2,0x66C2,
+    0x4AF3,0x7DC3,0x2493,0x13A3,0x9633,0xA103,0xF853,0xCF63,
+    },
+    {
+    0x0000,0x76B4,0xED68,0x9BDC,0xCAF1,0xBC45,0x2799,0x512D,
+    0x85C3,0xF377,0x68AB,0x1E1F,0x4F32,0x3986,0xA25A,0xD4EE,
+    0x1BA7,0x6D13,0xF6CF,0x807B,0xD156,0xA7E2,0x3C3E,0x4A8A,
+    0x9E64,0xE8D0,0x730C,0x05B8,0x5495,0x2221,0xB9FD,0xCF49,
+    0x374E,0x41FA,0xDA26,0xAC92,0xFDBF,0x8B0B,0x10D7,0x6663,
+    0xB28D,0xC439,0x5FE5,0x2951,0x787C,0x0EC8,0x9514,0xE3A0,
+    0x2CE9,0x5A5D,0xC181,0xB735,0xE618,0x90AC,0x0B70,0x7DC4,
+    0xA92A,0xDF9E,0x4442,0x32F6,0x63DB,0x156F,0x8EB3,0xF807,
+    0x6E9C,0x1828,0x83F4,0xF540,0xA46D,0xD2D9,0x4905,0x3FB1,
+    0xEB5F,0x9DEB,0x0637,0x7083,0x21AE,0x571A,0xCCC6,0xBA72,
+    0x753B,0x038F,0x9853,0xEEE7,0xBFCA,0xC97E,0x52A2,0x2416,
+    0xF0F8,0x864C,0x1D90,0x6B24,0x3A09,0x4CBD,0xD761,0xA1D5,
+    0x59D2,0x2F66,0xB4BA,0xC20E,0x9323,0xE597,0x7E4B,0x08FF,
+    0xDC11,0xAAA5,0x3179,0x47CD,0x16E0,0x6054,0xFB88,0x8D3C,
+    0x4275,0x34C1,0xAF1D,0xD9A9,0x8884,0xFE30,0x65EC,0x1358,
+    0xC7B6,0xB102,0x2ADE,0x5C6A,0x0D47,0x7BF3,0xE02F,0x969B,
+    0xDD38,0xAB8C,0x3050,0x46E4,0x17C9,0x617D,0xFAA1,0x8C15,
+    0x58FB,0x2E4F,0xB593,0xC327,0x920A,0xE4BE,0x7F62,0x09D6,
+    0xC69F,0xB02B,0x2BF7,0x5D43,0x0C6E,0x7ADA,0xE106,0x97B2,
+    0x435C,0x35E8,0xAE34,0xD880,0x89AD,0xFF19,0x64C5,0x1271,
+    0xEA76,0x9CC2,0x071E,0x71AA,0x2087,0x5633,0xCDEF,0xBB5B,
+    0x6FB5,0x1901,0x82DD,0xF469,0xA544,0xD3F0,0x482C,0x3E98,
+    0xF1D1,0x8765,0x1CB9,0x6A0D,0x3B20,0x4D94,0xD648,0xA0FC,
+    0x7412,0x02A6,0x997A,0xEFCE,0xBEE3,0xC857,0x538B,0x253F,
+    0xB3A4,0xC510,0x5ECC,0x2878,0x7955,0x0FE1,0x943D,0xE289,
+    0x3667,0x40D3,0xDB0F,0xADBB,0xFC96,0x8A22,0x11FE,0x674A,
+    0xA803,0xDEB7,0x456B,0x33DF,0x62F2,0x1446,0x8F9A,0xF92E,
+    0x2DC0,0x5B74,0xC0A8,0xB61C,0xE731,0x9185,0x0A59,0x7CED,
+    0x84EA,0xF25E,0x6982,0x1F36,0x4E1B,0x38AF,0xA373,0xD5C7,
+    0x0129,0x779D,0xEC41,0x9AF5,0xCBD8,0xBD6C,0x26B0,0x5004,
+    0x9F4D,0xE9F9,0x7225,0x0491,0x55BC,0x2308,0xB8D4,0xCE60,
+    0x1A8E,0x6C3A,0xF7E6,0x8152,0xD07F,0xA6CB,0x3D17,0x4BA3,
+    },
+};
+
 uint16_t
 crc_msb_first(uint16_t crc, uint8_t const *p, int len)
 {
-    while (len--) {
-        unsigned int i;
-        crc ^= (uint16_t)(uint8_t)*p++ << 8;
-        for (i = 0; i < 8; i++)
-            crc = (crc << 1) ^ ((crc & 0x8000) ? POLY_ITUT : 0);
+    /* four octets per iteration: CRC register is folded into the first two */
+    while (len >= 4) {
+        crc ^= (p[0] << 8) | p[1];
+        crc = crc16_table[3][crc >> 8] ^
+              crc16_table[2][crc & 0xff] ^
+              crc16_table[1][p[2]] ^
+              crc16_table[0][p[3]];
+        p += 4;
+        len -= 4;
     }
+
+    while (len-- > 0)
+        crc = crc_msb_first_byte(crc, *p++);
+
     return crc;
 }
 
-/* 18.1.2.5 of 802.15.4g-2012 */
+/* 18.1.2.5 of 802.15.4g-2012
+ * 00112233 44556677 8899aabb ccddeeff  src
+ * ffbb7733 eeaa6622 dd995511 cc884400  dst
+ * Each src octet is a row of four 2-bit symbols; row n lands in bits
+ * (2n+1, 2n) of every dst octet.  Automatically generated: symbols of
+ * one src octet spread to bits 1,0 of each dst octet (msb first word). */
+static const uint32_t interleave_table[256] = {
+    0x00000000,0x01000000,0x02000000,0x03000000,0x00010000,0x01010000,0x02010000,0x03010000,
+    0x00020000,0x01020000,0x02020000,0x03020000,0x00030000,0x01030000,0x02030000,0x03030000,
+    0x00000100,0x01000100,0x02000100,0x03000100,0x00010100,0x01010100,0x02010100,0x03010100,
+    0x00020100,0x01020100,0x02020100,0x03020100,0x00030100,0x01030100,0x02030100,0x03030100,
+    0x00000200,0x01000200,0x02000200,0x03000200,0x00010200,0x01010200,0x02010200,0x03010200,
+    0x00020200,0x01020200,0x02020200,0x03020200,0x00030200,0x01030200,0x02030200,0x03030200,
+    0x00000300,0x01000300,0x02000300,0x03000300,0x00010300,0x01010300,0x02010300,0x03010300,
+    0x00020300,0x01020300,0x02020300,0x03020300,0x00030300,0x01030300,0x02030300,0x03030300,
+    0x00000001,0x01000001,0x02000001,0x03000001,0x00010001,0x01010001,0x02010001,0x03010001,
+    0x00020001,0x01020001,0x02020001,0x03020001,0x00030001,0x01030001,0x02030001,0x03030001,
+    0x00000101,0x01000101,0x02000101,0x03000101,0x00010101,0x01010101,0x02010101,0x03010101,
+    0x00020101,0x01020101,0x02020101,0x03020101,0x00030101,0x01030101,0x02030101,0x03030101,
+    0x00000201,0x01000201,0x02000201,0x03000201,0x00010201,0x01010201,0x02010201,0x03010201,
+    0x00020201,0x01020201,0x02020201,0x03020201,0x00030201,0x01030201,0x02030201,0x03030201,
+    0x00000301,0x01000301,0x02000301,0x03000301,0x00010301,0x01010301,0x02010301,0x03010301,
+    0x00020301,0x01020301,0x02020301,0x03020301,0x00030301,0x01030301,0x02030301,0x03030301,
+    0x00000002,0x01000002,0x02000002,0x03000002,0x00010002,0x01010002,0x02010002,0x03010002,
+    0x00020002,0x01020002,0x02020002,0x03020002,0x00030002,0x01030002,0x02030002,0x03030002,
+    0x00000102,0x01000102,0x02000102,0x03000102,0x00010102,0x01010102,0x02010102,0x03010102,
+    0x00020102,0x01020102,0x02020102,0x03020102,0x00030102,0x01030102,0x02030102,0x03030102,
+    0x00000202,0x01000202,0x02000202,0x03000202,0x00010202,0x01010202,0x02010202,0x03010202,
+    0x00020202,0x01020202,0x02020202,0x03020202,0x00030202,0x01030202,0x02030202,0x03030202,
+    0x00000302,0x01000302,0x02000302,0x03000302,0x00010302,0x01010302,0x02010302,0x03010302,
+    0x00020302,0x01020302,0x02020302,0x03020302,0x00030302,0x01030302,0x02030302,0x03030302,
+    0x00000003,0x01000003,0x02000003,0x03000003,0x00010003,0x01010003,0x02010003,0x03010003,
+    0x00020003,0x01020003,0x02020003,0x03020003,0x00030003,0x01030003,0x02030003,0x03030003,
+    0x00000103,0x01000103,0x02000103,0x03000103,0x00010103,0x01010103,0x02010103,0x03010103,
+    0x00020103,0x01020103,0x02020103,0x03020103,0x00030103,0x01030103,0x02030103,0x03030103,
+    0x00000203,0x01000203,0x02000203,0x03000203,0x00010203,0x01010203,0x02010203,0x03010203,
+    0x00020203,0x01020203,0x02020203,0x03020203,0x00030203,0x01030203,0x02030203,0x03030203,
+    0x00000303,0x01000303,0x02000303,0x03000303,0x00010303,0x01010303,0x02010303,0x03010303,
+    0x00020303,0x01020303,0x02020303,0x03020303,0x00030303,0x01030303,0x02030303,0x03030303,
+};
+
+static inline uint32_t
+interleave_lut(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
+{
+    return interleave_table[b0] |
+           interleave_table[b1] << 2 |
+           interleave_table[b2] << 4 |
+           interleave_table[b3] << 6;
+}
+
 void
 interleave_u32(uint32_t *u32)
 {
-    uint32_t out;
-    // 00112233 44556677 8899aabb ccddeeff  src
-    // ffbb7733 eeaa6622 dd995511 cc884400  dst
- 
-    out = *u32 << 30;                   // ff to 00
-    out |= (*u32 & 0x00000300) << 20;   // bb to 11
-    out |= (*u32 & 0x00030000) << 10;   // 77 to 22
-    out |=  *u32 & 0x03000000;          // 33 to 33
-
-    out |= (*u32 & 0x0000000c) << 20;   // ee to 44
-    out |= (*u32 & 0x00000c00) << 10;   // aa to 55
-    out |=  *u32 & 0x000c0000;          // 66 to 66
-    out |= (*u32 & 0x0c000000) >> 10;   // 22 to 77
-
-    out |= (*u32 & 0x00000030) << 10;   // dd to 88
-    out |=  *u32 & 0x00003000;          // 99 to 99
-    out |= (*u32 & 0x00300000) >> 10;   // 55 to aa
-    out |= (*u32 & 0x30000000) >> 20;   // 11 to bb
-
-    out |=  *u32 & 0x000000c0;          // cc to cc
-    out |= (*u32 & 0x0000c000) >> 10;   // 88 to dd
-    out |= (*u32 & 0x00c00000) >> 20;   // 44 to ee
-    out |= (*u32 & 0xc0000000) >> 30;   // 00 to ff
-    //printf("in:%08x out:%08x\n", *u32, out);
-    *u32 = out;
+    uint32_t w = *u32;
+    *u32 = interleave_lut(w >> 24, w >> 16, w >> 8, w);
 }
 
 /* 18.1.2.5 of 802.15.4g-2012 */
@@ -194,26 +498,449 @@ void interleave(uint8_t *buf)
     buf[3] = out[3];
 }
 
+#ifdef HAVE_X86_DISPATCH
+/* Two blocks per 64-bit word: PEXT gathers one symbol column from every
+ * row (octet), PDEP places it as the dst octet of each block.
+ * Note PDEP/PEXT are microcoded (slow) on AMD before Zen 3. */
+__attribute__((target("bmi2")))
+static size_t
+interleave_frame_bmi2(uint8_t *buf, size_t len)
+{
+    const uint64_t col = 0x0303030303030303ULL;
+    const uint64_t row = 0x000000ff000000ffULL;
+    size_t done;
+
+    for (done = 0; done + 8 <= len; done += 8) {
+        uint64_t in, out;
+        memcpy(&in, buf + done, 8);     // octet 0 in lsbits
+        out  = _pdep_u64(_pext_u64(in, col     ), row      );
+        out |= _pdep_u64(_pext_u64(in, col << 2), row <<  8);
+        out |= _pdep_u64(_pext_u64(in, col << 4), row << 16);
+        out |= _pdep_u64(_pext_u64(in, col << 6), row << 24);
+        memcpy(buf + done, &out, 8);
+    }
+
+    return done;
+}
+#endif /* HAVE_X86_DISPATCH */
+
+void
+interleave_frame(uint8_t *buf, size_t len)
+{
+    size_t done = 0;
+
+#ifdef HAVE_X86_DISPATCH
+    if (cpu_features() & CPU_BMI2)
+        done = interleave_frame_bmi2(buf, len);
+#endif
+
+    for (; done + 4 <= len; done += 4) {
+        uint8_t *b = buf + done;
+        uint32_t w = interleave_lut(b[0], b[1], b[2], b[3]);
+        b[0] = w >> 24;
+        b[1] = w >> 16;
+        b[2] = w >> 8;
+        b[3] = w;
+    }
+}
+
+
+/* 18.1.2.4 of 802.15.4g-2012: NRNSC encoder, Figure 124.
+ * The code is linear, so the coded word of (state, octet) is
+ * nrnsc_octet_table[octet] ^ nrnsc_state_table[state].
+ * Automatically generated: octet encoded MSbit first from state 0,
+ * ui1 ui0 pairs from the msbit down, inverted as over the air. */
+static const uint16_t nrnsc_octet_table[256] = {
+    0xffff,0xfffc,0xfff2,0xfff1,0xffc8,0xffcb,0xffc5,0xffc6,
+    0xff20,0xff23,0xff2d,0xff2e,0xff17,0xff14,0xff1a,0xff19,
+    0xfc83,0xfc80,0xfc8e,0xfc8d,0xfcb4,0xfcb7,0xfcb9,0xfcba,
+    0xfc5c,0xfc5f,0xfc51,0xfc52,0xfc6b,0xfc68,0xfc66,0xfc65,
+    0xf20f,0xf20c,0xf202,0xf201,0xf238,0xf23b,0xf235,0xf236,
+    0xf2d0,0xf2d3,0xf2dd,0xf2de,0xf2e7,0xf2e4,0xf2ea,0xf2e9,
+    0xf173,0xf170,0xf17e,0xf17d,0xf144,0xf147,0xf149,0xf14a,
+    0xf1ac,0xf1af,0xf1a1,0xf1a2,0xf19b,0xf198,0xf196,0xf195,
+    0xc83f,0xc83c,0xc832,0xc831,0xc808,0xc80b,0xc805,0xc806,
+    0xc8e0,0xc8e3,0xc8ed,0xc8ee,0xc8d7,0xc8d4,0xc8da,0xc8d9,
+    0xcb43,0xcb40,0xcb4e,0xcb4d,0xcb74,0xcb77,0xcb79,0xcb7a,
+    0xcb9c,0xcb9f,0xcb91,0xcb92,0xcbab,0xcba8,0xcba6,0xcba5,
+    0xc5cf,0xc5cc,0xc5c2,0xc5c1,0xc5f8,0xc5fb,0xc5f5,0xc5f6,
+    0xc510,0xc513,0xc51d,0xc51e,0xc527,0xc524,0xc52a,0xc529,
+    0xc6b3,0xc6b0,0xc6be,0xc6bd,0xc684,0xc687,0xc689,0xc68a,
+    0xc66c,0xc66f,0xc661,0xc662,0xc65b,0xc658,0xc656,0xc655,
+    0x20ff,0x20fc,0x20f2,0x20f1,0x20c8,0x20cb,0x20c5,0x20c6,
+    0x2020,0x2023,0x202d,0x202e,0x2017,0x2014,0x201a,0x2019,
+    0x2383,0x2380,0x238e,0x238d,0x23b4,0x23b7,0x23b9,0x23ba,
+    0x235c,0x235f,0x2351,0x2352,0x236b,0x2368,0x2366,0x2365,
+    0x2d0f,0x2d0c,0x2d02,0x2d01,0x2d38,0x2d3b,0x2d35,0x2d36,
+    0x2dd0,0x2dd3,0x2ddd,0x2dde,0x2de7,0x2de4,0x2dea,0x2de9,
+    0x2e73,0x2e70,0x2e7e,0x2e7d,0x2e44,0x2e47,0x2e49,0x2e4a,
+    0x2eac,0x2eaf,0x2ea1,0x2ea2,0x2e9b,0x2e98,0x2e96,0x2e95,
+    0x173f,0x173c,0x1732,0x1731,0x1708,0x170b,0x1705,0x1706,
+    0x17e0,0x17e3,0x17ed,0x17ee,0x17d7,0x17d4,0x17da,0x17d9,
+    0x1443,0x1440,0x144e,0x144d,0x1474,0x1477,0x1479,0x147a,
+    0x149c,0x149f,0x1491,0x1492,0x14ab,0x14a8,0x14a6,0x14a5,
+    0x1acf,0x1acc,0x1ac2,0x1ac1,0x1af8,0x1afb,0x1af5,0x1af6,
+    0x1a10,0x1a13,0x1a1d,0x1a1e,0x1a27,0x1a24,0x1a2a,0x1a29,
+    0x19b3,0x19b0,0x19be,0x19bd,0x1984,0x1987,0x1989,0x198a,
+    0x196c,0x196f,0x1961,0x1962,0x195b,0x1958,0x1956,0x1955,
+};
+
+/* contribution of M0..M2 to the coded word of an all-zero octet */
+static const uint16_t nrnsc_state_table[8] = {
+    0x0000, 0x7c00, 0xf000, 0x8c00, 0xc000, 0xbc00, 0x3000, 0x4c00
+};
 
 uint8_t
-get_pn9_byte(uint16_t *_lfsr)
+nrnsc_encode(uint8_t *out, const uint8_t *in, size_t len, uint8_t state)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        uint8_t octet = in[i];
+        uint16_t w = nrnsc_octet_table[octet] ^ nrnsc_state_table[state];
+        out[0] = w >> 8;
+        out[1] = w & 0xff;
+        out += 2;
+        /* M0..M2 are the last three input bits */
+        state = octet & 7;
+    }
+
+    return state;
+}
+
+size_t
+nrnsc_encode_tail(uint8_t *out, size_t phr_psdu_len, uint8_t state)
+{
+    /* three tail bits 000, then pad 01011 or 0101100001011:
+     * exactly one or two octets of 0x0b, to a multiple of 32 coded bits */
+    static const uint8_t tail_pad[2] = { 0x0b, 0x0b };
+    size_t n = (phr_psdu_len & 1) ? 1 : 2;
+
+    nrnsc_encode(out, tail_pad, n, state);
+
+    return n * 2;
+}
+
+/* 18.1.2.5 interleaver as a permutation of coded bit positions within a
+ * 32-bit block, MSbit of the first octet at 0: dst bit i is src bit
+ * interleave_perm[i]. It is its own inverse. */
+static const uint8_t interleave_perm[32] = {
+    30, 31, 22, 23, 14, 15,  6,  7, 28, 29, 20, 21, 12, 13,  4,  5,
+    26, 27, 18, 19, 10, 11,  2,  3, 24, 25, 16, 17,  8,  9,  0,  1,
+};
+
+void
+deinterleave_soft(int8_t *out, const int8_t *in)
+{
+    int i;
+
+    for (i = 0; i < 32; i++)
+        out[interleave_perm[i]] = in[i];
+}
+
+/* NRNSC trellis: state is the last three input bits, newest in bit 0, so
+ * state s with input u goes to ((s << 1) | u) & 7. Next state ns is reached
+ * from ns >> 1 and (ns >> 1) | 4; those differ only in the oldest bit,
+ * which both generators tap, so their branch metrics are negatives.
+ * Metrics are correlations, larger is better; each step is renormalized
+ * to state 0 so int16 never overflows. */
+#define NRNSC_METRIC_NONE   (-0x2000)   // state not reachable at start
+
+void
+nrnsc_viterbi_init(int16_t metric[NRNSC_STATES], uint8_t state)
+{
+    int s;
+
+    for (s = 0; s < NRNSC_STATES; s++)
+        metric[s] = s == state ? 0 : NRNSC_METRIC_NONE;
+}
+
+/* over-the-air ui1 (g1 = 1011) and ui0 (g0 = 1111) of the branch from
+ * (ns >> 1) into ns, as +1 / -1: coded bits are sent inverted */
+#define NRNSC_SIGN(c)   ((c) ? -1 : 1)
+#define NRNSC_UI1(ns)   NRNSC_SIGN((((ns) ^ ((ns) >> 2)) & 1))
+#define NRNSC_UI0(ns)   NRNSC_SIGN((((ns) ^ ((ns) >> 1) ^ ((ns) >> 2)) & 1))
+
+#ifdef __SSE2__
+/* all eight states in one register */
+static void
+nrnsc_viterbi_acs_sse2(int16_t metric[NRNSC_STATES], uint8_t *decisions,
+    const int8_t *soft, size_t nbits)
+{
+    /* all-ones where the branch from ns >> 1 negates the soft value */
+#define NEG(ns, f)  (f(ns) < 0 ? -1 : 0)
+    const __m128i neg1 = _mm_setr_epi16(NEG(0, NRNSC_UI1), NEG(1, NRNSC_UI1),
+        NEG(2, NRNSC_UI1), NEG(3, NRNSC_UI1), NEG(4, NRNSC_UI1),
+        NEG(5, NRNSC_UI1), NEG(6, NRNSC_UI1), NEG(7, NRNSC_UI1));
+    const __m128i neg0 = _mm_setr_epi16(NEG(0, NRNSC_UI0), NEG(1, NRNSC_UI0),
+        NEG(2, NRNSC_UI0), NEG(3, NRNSC_UI0), NEG(4, NRNSC_UI0),
+        NEG(5, NRNSC_UI0), NEG(6, NRNSC_UI0), NEG(7, NRNSC_UI0));
+#undef NEG
+    __m128i m = _mm_loadu_si128((const __m128i *)metric);
+    size_t t;
+
+    for (t = 0; t < nbits; t++) {
+        __m128i y1 = _mm_set1_epi16(soft[2*t]);
+        __m128i y0 = _mm_set1_epi16(soft[2*t+1]);
+        __m128i bm, p0, p1, d, m0;
+
+        bm = _mm_add_epi16(_mm_sub_epi16(_mm_xor_si128(y1, neg1), neg1),
+                           _mm_sub_epi16(_mm_xor_si128(y0, neg0), neg0));
+        p0 = _mm_add_epi16(_mm_unpacklo_epi16(m, m), bm);   // from ns >> 1
+        p1 = _mm_sub_epi16(_mm_unpackhi_epi16(m, m), bm);   // from (ns >> 1) | 4
+        d = _mm_cmpgt_epi16(p1, p0);
+        decisions[t] = _mm_movemask_epi8(_mm_packs_epi16(d, d)) & 0xff;
+        m = _mm_max_epi16(p0, p1);
+        m0 = _mm_shufflelo_epi16(m, 0);
+        m = _mm_sub_epi16(m, _mm_unpacklo_epi64(m0, m0));
+    }
+    _mm_storeu_si128((__m128i *)metric, m);
+}
+#endif /* __SSE2__ */
+
+void
+nrnsc_viterbi_acs(int16_t metric[NRNSC_STATES], uint8_t *decisions,
+    const int8_t *soft, size_t nbits)
+{
+#ifdef __SSE2__
+    nrnsc_viterbi_acs_sse2(metric, decisions, soft, nbits);
+#else
+    int16_t m[NRNSC_STATES];
+    size_t t;
+    int ns;
+
+    for (t = 0; t < nbits; t++) {
+        uint8_t dec = 0;
+        for (ns = 0; ns < NRNSC_STATES; ns++) {
+            int16_t bm = NRNSC_UI1(ns) * soft[2*t] + NRNSC_UI0(ns) * soft[2*t+1];
+            int16_t p0 = metric[ns >> 1] + bm;
+            int16_t p1 = metric[(ns >> 1) | 4] - bm;
+            if (p1 > p0) {
+                dec |= 1 << ns;
+                m[ns] = p1;
+            } else
+                m[ns] = p0;
+        }
+        decisions[t] = dec;
+        for (ns = NRNSC_STATES - 1; ns >= 0; ns--)
+            metric[ns] = m[ns] - m[0];
+    }
+#endif
+}
+
+uint8_t
+nrnsc_viterbi_best(const int16_t metric[NRNSC_STATES])
 {
-    int xor_out;
-    uint8_t bp, ret = 0;
-    uint16_t lfsr = *_lfsr;
-    
-    for (bp = 0x80; bp > 0; bp >>= 1) {
-        xor_out = ((lfsr >> 5) & 1) ^ (lfsr & 1);
-        lfsr = (lfsr >> 1) | (xor_out << 8);
-        if (lfsr & 0x100)
-            ret |= bp;
+    uint8_t s, best = 0;
+
+    for (s = 1; s < NRNSC_STATES; s++) {
+        if (metric[s] > metric[best])
+            best = s;
     }
 
-    *_lfsr = lfsr;
+    return best;
+}
+
+void
+nrnsc_viterbi_traceback(uint8_t *out, const uint8_t *decisions, size_t nbits, uint8_t state)
+{
+    size_t t;
+
+    memset(out, 0, (nbits + 7) / 8);
+    for (t = nbits; t-- > 0; ) {
+        if (state & 1)
+            out[t >> 3] |= 0x80 >> (t & 7);
+        state = (state >> 1) | (((decisions[t] >> state) & 1) << 2);
+    }
+}
+
+
+/* 18.1.3 of 802.15.4g-2012: PN9 whitening, x^9 + x^5 + 1
+ * Automatically generated: octets from seed 0x1ff, one full period.
+ * 511 is prime to 8, so every LFSR state begins exactly one octet. */
+const uint8_t pn9_table[PN9_PERIOD] = {
+    0x0f,0x70,0xb3,0x6f,0x43,0x98,0x48,0xae,0xbc,0x97,0x38,0x1d,0xd3,0xd4,0xa0,0x55,
+    0x7d,0x68,0x37,0x6d,0x60,0xbb,0xe3,0xcd,0x35,0xc6,0x8b,0xfa,0x58,0xa6,0x30,0x19,
+    0x95,0x93,0xf6,0x92,0x6f,0xcb,0x50,0xa2,0x76,0x5e,0xc3,0x54,0xe4,0x31,0x08,0x04,
+    0x46,0x47,0x56,0xc7,0x12,0xa3,0x67,0xcf,0x16,0xe5,0x20,0x99,0xd1,0xf7,0x83,0xfe,
+    0x1e,0xe1,0x66,0xde,0x87,0x30,0x91,0x5d,0x79,0x2e,0x70,0x3b,0xa7,0xa9,0x40,0xaa,
+    0xfa,0xd0,0x6e,0xda,0xc1,0x77,0xc7,0x9a,0x6b,0x8d,0x17,0xf4,0xb1,0x4c,0x60,0x33,
+    0x2b,0x27,0xed,0x24,0xdf,0x96,0xa1,0x44,0xec,0xbd,0x86,0xa9,0xc8,0x62,0x10,0x08,
+    0x8c,0x8e,0xad,0x8e,0x25,0x46,0xcf,0x9e,0x2d,0xca,0x41,0x33,0xa3,0xef,0x07,0xfc,
+    0x3d,0xc2,0xcd,0xbd,0x0e,0x61,0x22,0xba,0xf2,0x5c,0xe0,0x77,0x4f,0x52,0x81,0x55,
+    0xf5,0xa0,0xdd,0xb5,0x82,0xef,0x8f,0x34,0xd7,0x1a,0x2f,0xe9,0x62,0x98,0xc0,0x66,
+    0x56,0x4f,0xda,0x49,0xbf,0x2d,0x42,0x89,0xd9,0x7b,0x0d,0x53,0x90,0xc4,0x20,0x11,
+    0x19,0x1d,0x5b,0x1c,0x4a,0x8d,0x9f,0x3c,0x5b,0x94,0x82,0x67,0x47,0xde,0x0f,0xf8,
+    0x7b,0x85,0x9b,0x7a,0x1c,0xc2,0x45,0x75,0xe4,0xb9,0xc0,0xee,0x9e,0xa5,0x02,0xab,
+    0xeb,0x41,0xbb,0x6b,0x05,0xdf,0x1e,0x69,0xae,0x34,0x5f,0xd2,0xc5,0x31,0x80,0xcc,
+    0xac,0x9f,0xb4,0x93,0x7e,0x5a,0x85,0x13,0xb2,0xf6,0x1a,0xa7,0x21,0x88,0x40,0x22,
+    0x32,0x3a,0xb6,0x38,0x95,0x1b,0x3e,0x78,0xb7,0x29,0x04,0xce,0x8f,0xbc,0x1f,0xf0,
+    0xf7,0x0b,0x36,0xf4,0x39,0x84,0x8a,0xeb,0xc9,0x73,0x81,0xdd,0x3d,0x4a,0x05,0x57,
+    0xd6,0x83,0x76,0xd6,0x0b,0xbe,0x3c,0xd3,0x5c,0x68,0xbf,0xa5,0x8a,0x63,0x01,0x99,
+    0x59,0x3f,0x69,0x26,0xfc,0xb5,0x0a,0x27,0x65,0xec,0x35,0x4e,0x43,0x10,0x80,0x44,
+    0x64,0x75,0x6c,0x71,0x2a,0x36,0x7c,0xf1,0x6e,0x52,0x09,0x9d,0x1f,0x78,0x3f,0xe1,
+    0xee,0x16,0x6d,0xe8,0x73,0x09,0x15,0xd7,0x92,0xe7,0x03,0xba,0x7a,0x94,0x0a,0xaf,
+    0xad,0x06,0xed,0xac,0x17,0x7c,0x79,0xa6,0xb8,0xd1,0x7f,0x4b,0x14,0xc6,0x03,0x32,
+    0xb2,0x7e,0xd2,0x4d,0xf9,0x6a,0x14,0x4e,0xcb,0xd8,0x6a,0x9c,0x86,0x21,0x00,0x88,
+    0xc8,0xea,0xd8,0xe2,0x54,0x6c,0xf9,0xe2,0xdc,0xa4,0x13,0x3a,0x3e,0xf0,0x7f,0xc3,
+    0xdc,0x2c,0xdb,0xd0,0xe6,0x12,0x2b,0xaf,0x25,0xce,0x07,0x74,0xf5,0x28,0x15,0x5f,
+    0x5a,0x0d,0xdb,0x58,0x2e,0xf8,0xf3,0x4d,0x71,0xa2,0xfe,0x96,0x29,0x8c,0x06,0x65,
+    0x64,0xfd,0xa4,0x9b,0xf2,0xd4,0x28,0x9d,0x97,0xb0,0xd5,0x39,0x0c,0x42,0x01,0x11,
+    0x91,0xd5,0xb1,0xc4,0xa8,0xd9,0xf3,0xc5,0xb9,0x48,0x26,0x74,0x7d,0xe0,0xff,0x87,
+    0xb8,0x59,0xb7,0xa1,0xcc,0x24,0x57,0x5e,0x4b,0x9c,0x0e,0xe9,0xea,0x50,0x2a,0xbe,
+    0xb4,0x1b,0xb6,0xb0,0x5d,0xf1,0xe6,0x9a,0xe3,0x45,0xfd,0x2c,0x53,0x18,0x0c,0xca,
+    0xc9,0xfb,0x49,0x37,0xe5,0xa8,0x51,0x3b,0x2f,0x61,0xaa,0x72,0x18,0x84,0x02,0x23,
+    0x23,0xab,0x63,0x89,0x51,0xb3,0xe7,0x8b,0x72,0x90,0x4c,0xe8,0xfb,0xc1,0xff,
+};
+
+/* offset into pn9_table[] of next octet, for each LFSR state */
+static const uint16_t pn9_index[512] = {
+      0,367,303,223,239, 79,159,203,
+    175, 59, 15,146, 95, 21,139,446,
+    111,302,506,173,462, 39, 82,388,
+     31, 70,468,426, 75,  2,382,256,
+    112, 47,368,238,  7,442,369,109,
+    423,398,437,486,282, 18,508,324,
+    493,478,158,  6, 29,404,371,362,
+    244, 11,345,449,248,318,406,192,
+     48,251,494,262,304,104,174,436,
+    454,100,378,419,305,417, 45,201,
+    359,349,334,186,373, 44,422, 14,
+    218,152,465,227,444,396,260, 92,
+    479,429,113,414,507, 94,224,453,
+    386,476,225,340,374,307,105,298,
+    197,180,364,458,138,281,377,385,
+    279,184,  9,254,311,342,293,128,
+    495,207,187,149,430,167,198,130,
+    240,135, 40,410,110,157,372,376,
+    390, 53, 36,329,314,142,355,220,
+    241,352,353,233,492,505,137,421,
+    335,295,263,285,181,270,480,122,
+    463,309, 80,491,363,358,370,461,
+    235,154,472, 88,230,401, 84,163,
+    242,380,136,332,333,196, 81, 28,
+    415,338,365,107, 49,118,350, 26,
+    443,292, 30,344,160, 67,389,471,
+    322, 57,412,102,161, 51,276,273,
+    310,259,243,467, 41,275,234, 35,
+    459,133,114,116,360,300,252,394,
+    405, 74,  8,217, 83,313,204,321,
+     65,215,205,120, 42,456, 68,190,
+    381,247,464,278,354,229,411, 64,
+    431,287,143,267,123,210, 85,510,
+    366,237,103,452,134,490, 66,320,
+    176,432, 71,433,487,501,346, 61,
+     46,222, 93,435,308,409,312,470,
+    315,326,168,500,164,483,481,265,
+    413,250,108, 78,216,291,460,156,
+     32,177, 60,288,450,289,438,169,
+    261,428,202,441,343, 73,375,357,
+    271,213,231,194,199,474,221,440,
+    117,393,206,284,416,297, 58,485,
+    399,327,245, 33, 16,144,427,434,
+    299, 25,294,148,306,200,397,145,
+    402,171,182, 90,356,408,131, 24,
+    121,166,115,337,323, 20,339, 99,
+     12,178,424,316,469, 72,147,268,
+    129,269,106,132,445, 17,418,475,
+    351,331,274, 63,301,  5, 43,384,
+    496,497, 54,125,286,499,473, 23,
+    379,232,228, 34,477,172,280, 13,
+     96,124,  3,502,325,266,407,439,
+    277,258, 27,504,457,348,361, 38,
+    391, 97,208,498, 89,212,264,209,
+    466,246,420,195,185,179,387,403,
+     76,488, 22,211,193,170,509,482,
+    395,127, 69,448, 50,189, 52, 87,
+    296, 98,236, 77,188, 55,330,503,
+    341, 91, 10,425,455,272,153,328,
+     19,484,249,451,140, 86,257, 62,
+    191,  1,253,151,162,141,119, 56,
+    155,489,336,392, 37,  4,150,126,
+    255,317,226,183,219,400,101,214,
+    319,290,283,165,383,347,447,  0,
+};
+
+uint8_t
+get_pn9_byte(uint16_t *_lfsr)
+{
+    uint16_t lfsr = *_lfsr & 0x1ff;
+    uint8_t ret;
+
+    if (lfsr == 0)
+        return 0;   // stuck, as the LFSR itself would be
+
+    ret = pn9_table[pn9_index[lfsr]];
+    /* LFSR state is always the last 9 bits output */
+    *_lfsr = (reverse_octet(ret) << 1) | ((lfsr >> 8) & 1);
 
     return ret;
 }
 
+static void
+xor_octets(uint8_t *dst, const uint8_t *src, size_t len)
+{
+#ifdef __SSE2__
+    while (len >= 16) {
+        __m128i d = _mm_loadu_si128((const __m128i *)dst);
+        __m128i s = _mm_loadu_si128((const __m128i *)src);
+        _mm_storeu_si128((__m128i *)dst, _mm_xor_si128(d, s));
+        dst += 16;
+        src += 16;
+        len -= 16;
+    }
+#endif
+    while (len-- > 0)
+        *dst++ ^= *src++;
+}
+
+void
+pn9_xor(uint8_t *buf, size_t len, uint16_t *_lfsr)
+{
+    uint16_t lfsr = *_lfsr & 0x1ff;
+    size_t idx, n, last, prev;
+
+    if (lfsr == 0 || len == 0)
+        return;
+
+    idx = pn9_index[lfsr];
+    while (len > 0) {
+        n = PN9_PERIOD - idx;
+        if (n > len)
+            n = len;
+        xor_octets(buf, pn9_table + idx, n);
+        buf += n;
+        len -= n;
+        idx += n;
+        if (idx == PN9_PERIOD)
+            idx = 0;
+    }
+
+    /* LFSR state is always the last 9 bits output */
+    last = idx == 0 ? PN9_PERIOD - 1 : idx - 1;
+    prev = last == 0 ? PN9_PERIOD - 1 : last - 1;
+    *_lfsr = (reverse_octet(pn9_table[last]) << 1) | (pn9_table[prev] & 1);
+}
+
+/* PN15, x^15 + x^14 + 1 from seed 0x7fff, same bit order as PN9 above */
+void
+pn15_generate(uint8_t *buf, size_t len)
+{
+    uint16_t lfsr = PN15_SEED;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        uint8_t bp, ret = 0;
+        for (bp = 0x80; bp > 0; bp >>= 1) {
+            int xor_out = ((lfsr >> 1) & 1) ^ (lfsr & 1);
+            lfsr = (lfsr >> 1) | (xor_out << 14);
+            if (lfsr & 0x4000)
+                ret |= bp;
+        }
+        buf[i] = ret;
+    }
+}
+
 uint8_t
 reverse_octet(uint8_t octet)
 {
@@ -231,3 +958,309 @@ reverse_octet(uint8_t octet)
     return ret;
 }
 
+
+size_t
+mrfsk_frame_length(int preamble_size, int fec_en, int crc_type_16, size_t payload_len)
+{
+    size_t phr_psdu_len = PHR_LENGTH + payload_len + (crc_type_16 ? 2 : 4);
+
+    /* preamble + SFD, then PHR and PSDU: as is, or coded with tail and pad */
+    if (fec_en)
+        return preamble_size + 2 + 2 * phr_psdu_len + ((phr_psdu_len & 1) ? 2 : 4);
+    return preamble_size + 2 + phr_psdu_len;
+}
+
+/* 18.1.1 and 18.1.2 of 802.15.4g-2012: complete over-the-air frame.
+ * PHR and PSDU are assembled in place at the back of the coded region,
+ * so that NRNSC encoding (two octets out per octet in) runs forward
+ * over them without a separate copy. */
+int
+mrfsk_encode_frame(uint8_t *ota, size_t ota_size, int preamble_size,
+    int fec_en, int dw, int crc_type_16,
+    const uint8_t *payload, size_t payload_len)
+{
+    size_t fcs_len = crc_type_16 ? 2 : 4;
+    size_t psdu_len = payload_len + fcs_len;
+    size_t phr_psdu_len = PHR_LENGTH + psdu_len;
+    size_t hdr_len = preamble_size + 2;     // preamble + SFD
+    size_t coded_len, n;
+    size_t ota_len = mrfsk_frame_length(preamble_size, fec_en, crc_type_16, payload_len);
+    uint8_t *phr_psdu, *psdu;
+    MRFSK_PHR_t phr;
+    uint16_t lfsr;
+
+    if (preamble_size < 0 || psdu_len > aMaxPHYPacketSize || ota_len > ota_size)
+        return -1;
+
+    /* tail and pad make coded length a multiple of 32 bits */
+    coded_len = ota_len - hdr_len;
+    if (fec_en)
+        phr_psdu = ota + hdr_len + coded_len - phr_psdu_len;
+    else
+        phr_psdu = ota + hdr_len;
+    psdu = phr_psdu + PHR_LENGTH;
+
+    memset(ota, 0x55, preamble_size);
+    ota[preamble_size] = fec_en ? 0x6f : 0x90;
+    ota[preamble_size + 1] = 0x4e;
+
+    phr.word = 0;
+    phr.bits.DW = dw ? 1 : 0;
+    phr.bits.FCS = crc_type_16 ? 1 : 0;
+    phr.bits.frame_length = psdu_len;
+    phr_psdu[0] = phr.word >> 8;
+    phr_psdu[1] = phr.word & 0xff;
+
+    memcpy(psdu, payload, payload_len);
+    n = payload_len;
+    if (crc_type_16) {
+        uint16_t crc16 = crc_msb_first(INITIAL_CRC16, psdu, n);
+        psdu[n++] = crc16 >> 8;
+        psdu[n++] = crc16 & 0xff;
+    } else {
+        static const uint8_t z[4] = { 0, 0, 0, 0 };
+        uint32_t crc_32 = digital_update_crc32(INITIAL_CRC32, psdu, n);
+        if (n < 4)  // zero padded to 4 octets, 5.2.1.9
+            crc_32 = digital_update_crc32(crc_32, z, 4 - n);
+        crc_32 = ~crc_32;
+        psdu[n++] = crc_32 >> 24;
+        psdu[n++] = crc_32 >> 16;
+        psdu[n++] = crc_32 >> 8;
+        psdu[n++] = crc_32 & 0xff;
+    }
+
+    if (dw) {
+        lfsr = PN9_SEED;
+        pn9_xor(psdu, psdu_len, &lfsr);
+    }
+
+    if (fec_en) {
+        uint8_t *coded = ota + hdr_len;
+        uint8_t state = nrnsc_encode(coded, phr_psdu, phr_psdu_len, NRNSC_STATE_INIT);
+        nrnsc_encode_tail(coded + 2 * phr_psdu_len, phr_psdu_len, state);
+        interleave_frame(coded, coded_len);
+    }
+
+    return ota_len;
+}
+
+
+/* Preamble detector windows, scalar: min_val < x and x > max_val keep the
+ * first of equal samples, and skip NaN */
+static void
+preamble_windows_generic(preamble_window_t *out, const float *in, int len, int nwin)
+{
+    int w, n;
+
+    for (w = 0; w < nwin; w++, in += len) {
+        /* in locals: out may alias in as far as the compiler knows */
+        float min_val = PREAMBLE_WINDOW_MIN, max_val = PREAMBLE_WINDOW_MAX;
+        int min_at = -1, max_at = -1, nonzero = 0;
+        for (n = 0; n < len; n++) {
+            if (in[n] != 0)
+                nonzero = 1;
+            if (in[n] < min_val) {
+                min_val = in[n];
+                min_at = n;
+            }
+            if (in[n] > max_val) {
+                max_val = in[n];
+                max_at = n;
+            }
+        }
+        out[w].min_val = min_val;
+        out[w].max_val = max_val;
+        out[w].min_at = min_at;
+        out[w].max_at = max_at;
+        out[w].zeros = !nonzero;
+    }
+}
+
+static void
+preamble_crossings_generic(const float *in, int len, float mid, int first,
+    int *zcu_at, int *zcd_at)
+{
+    int n, up = -1, dn = -1;
+
+    for (n = first ? 1 : 0; n < len; n++) {
+        if (in[n-1] < mid && in[n] >= mid)
+            up = n;
+        else if (in[n-1] >= mid && in[n] < mid)
+            dn = n;
+    }
+    *zcu_at = up;
+    *zcd_at = dn;
+}
+
+#ifdef HAVE_X86_DISPATCH
+__attribute__((target("avx2")))
+static inline float
+hmin_avx2(__m256 v)
+{
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(m, m, 1)));
+}
+
+__attribute__((target("avx2")))
+static inline float
+hmax_avx2(__m256 v)
+{
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+}
+
+/* Eight samples a step, the last step of a window through a lane mask so
+ * any len works. min_ps(x, acc) returns acc for NaN x, as the scalar
+ * compares do. Min and max are found first, then their first index by
+ * compare and movemask on the window, which is still in L1. */
+__attribute__((target("avx2,bmi")))
+static void
+preamble_windows_avx2(preamble_window_t *out, const float *in, int len, int nwin)
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i tail = _mm256_cmpgt_epi32(_mm256_set1_epi32(len & 7), lane);
+    const __m256 init_min = _mm256_set1_ps(PREAMBLE_WINDOW_MIN);
+    const __m256 init_max = _mm256_set1_ps(PREAMBLE_WINDOW_MAX);
+    const __m256 zero = _mm256_setzero_ps();
+    const int full = len & ~7;
+    int w, n;
+
+    for (w = 0; w < nwin; w++, in += len) {
+        preamble_window_t *o = &out[w];
+        __m256 vmin = init_min, vmax = init_max, nz = zero, x;
+        unsigned int mmin = 0, mmax = 0;
+
+        for (n = 0; n < full; n += 8) {
+            x = _mm256_loadu_ps(in + n);
+            vmin = _mm256_min_ps(x, vmin);
+            vmax = _mm256_max_ps(x, vmax);
+            nz = _mm256_or_ps(nz, _mm256_cmp_ps(x, zero, _CMP_NEQ_UQ));
+        }
+        if (n < len) {
+            x = _mm256_maskload_ps(in + n, tail);
+            vmin = _mm256_min_ps(_mm256_blendv_ps(init_min, x, _mm256_castsi256_ps(tail)), vmin);
+            vmax = _mm256_max_ps(_mm256_blendv_ps(init_max, x, _mm256_castsi256_ps(tail)), vmax);
+            nz = _mm256_or_ps(nz, _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_NEQ_UQ),
+                    _mm256_castsi256_ps(tail)));
+        }
+        o->zeros = _mm256_movemask_ps(nz) == 0;
+        o->min_val = hmin_avx2(vmin);
+        o->max_val = hmax_avx2(vmax);
+        /* not below the initial value: never updated */
+        o->min_at = o->min_val < PREAMBLE_WINDOW_MIN ? -2 : -1;
+        o->max_at = o->max_val > PREAMBLE_WINDOW_MAX ? -2 : -1;
+        vmin = _mm256_set1_ps(o->min_val);
+        vmax = _mm256_set1_ps(o->max_val);
+
+        for (n = 0; n < len && (o->min_at == -2 || o->max_at == -2); n += 8) {
+            unsigned int valid = n + 8 <= len ? 0xff : (1u << (len & 7)) - 1;
+            x = n + 8 <= len ? _mm256_loadu_ps(in + n) : _mm256_maskload_ps(in + n, tail);
+            mmin = _mm256_movemask_ps(_mm256_cmp_ps(x, vmin, _CMP_EQ_OQ)) & valid;
+            mmax = _mm256_movemask_ps(_mm256_cmp_ps(x, vmax, _CMP_EQ_OQ)) & valid;
+            if (o->min_at == -2 && mmin)
+                o->min_at = n + __builtin_ctz(mmin);
+            if (o->max_at == -2 && mmax)
+                o->max_at = n + __builtin_ctz(mmax);
+        }
+        /* min_ps and max_ps pick either of +0 and -0, take the sample */
+        if (o->min_at >= 0)
+            o->min_val = in[o->min_at];
+        if (o->max_at >= 0)
+            o->max_val = in[o->max_at];
+    }
+}
+
+/* One bit per sample, 64 to a word: G for >= mid, L for < mid (both clear
+ * for NaN). A rising crossing at n is L at n-1 and G at n; the last one is
+ * the highest set bit. Bit 63 of each word carries over to the next. */
+__attribute__((target("avx2,bmi")))
+static void
+preamble_crossings_avx2(const float *in, int len, float mid, int first,
+    int *zcu_at, int *zcd_at)
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 m = _mm256_set1_ps(mid);
+    uint64_t gc, lc;    // carry: sample before this word
+    int base, n;
+
+    *zcu_at = -1;
+    *zcd_at = -1;
+    if (first) {
+        gc = 0;
+        lc = 0;
+    } else {
+        gc = in[-1] >= mid;
+        lc = in[-1] < mid;
+    }
+
+    for (base = 0; base < len; base += 64) {
+        uint64_t g = 0, l = 0, up, dn;
+        int end = len - base < 64 ? len - base : 64;
+
+        for (n = 0; n < end; n += 8) {
+            __m256 x;
+            if (n + 8 <= end) {
+                x = _mm256_loadu_ps(in + base + n);
+            } else {
+                __m256i tail = _mm256_cmpgt_epi32(_mm256_set1_epi32(end - n), lane);
+                x = _mm256_maskload_ps(in + base + n, tail);
+            }
+            g |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(x, m, _CMP_GE_OQ)) << n;
+            l |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(x, m, _CMP_LT_OQ)) << n;
+        }
+        if (end < 64) {
+            g &= (1ULL << end) - 1;
+            l &= (1ULL << end) - 1;
+        }
+        up = ((l << 1) | lc) & g;
+        dn = ((g << 1) | gc) & l;
+        if (base == 0 && first) {
+            up &= ~1ULL;
+            dn &= ~1ULL;
+        }
+        if (up)
+            *zcu_at = base + 63 - __builtin_clzll(up);
+        if (dn)
+            *zcd_at = base + 63 - __builtin_clzll(dn);
+        gc = g >> 63;
+        lc = l >> 63;
+    }
+}
+#endif /* HAVE_X86_DISPATCH */
+
+int
+cpu_has_avx2(void)
+{
+#ifdef HAVE_X86_DISPATCH
+    return (cpu_features() & CPU_AVX2) != 0;
+#else
+    return 0;
+#endif
+}
+
+void
+preamble_windows(preamble_window_t *out, const float *in, int len, int nwin)
+{
+#ifdef HAVE_X86_DISPATCH
+    if (cpu_features() & CPU_AVX2) {
+        preamble_windows_avx2(out, in, len, nwin);
+        return;
+    }
+#endif
+    preamble_windows_generic(out, in, len, nwin);
+}
+
+void
+preamble_crossings(const float *in, int len, float mid, int first,
+    int *zcu_at, int *zcd_at)
+{
+#ifdef HAVE_X86_DISPATCH
+    if (cpu_features() & CPU_AVX2) {
+        preamble_crossings_avx2(in, len, mid, first, zcu_at, zcd_at);
+        return;
+    }
+#endif
+    preamble_crossings_generic(in, len, mid, first, zcu_at, zcd_at);
+}
@@ -17,7 +17,11 @@
  * the Free Software Foundation, Inc., 51 Franklin Street,
  * Boston, MA 02110-1301, USA.
  */
+#ifndef INCLUDED_IEEE802154G_UTILS_MRFSK_H
+#define INCLUDED_IEEE802154G_UTILS_MRFSK_H
+
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,13 +46,105 @@ typedef union { // as defined in section 18.1.1.3
 #define INITIAL_CRC32   0xffffffff
 
 unsigned int digital_update_crc32(unsigned int crc, const unsigned char *data, size_t len);
+
+extern const uint16_t crc16_table[4][256];
+
+/* CRC16 over whole buffer, e.g. entire PSDU */
 uint16_t crc_msb_first(uint16_t crc, uint8_t const *p, int len);
+
+/* CRC16 of single octet */
+static inline uint16_t
+crc_msb_first_byte(uint16_t crc, uint8_t octet)
+{
+    return (crc << 8) ^ crc16_table[0][(crc >> 8) ^ octet];
+}
+
 void interleave_u32(uint32_t *u32);
 void interleave(uint8_t *buf);
+/* (de)interleave len/4 consecutive 32-bit blocks, the permutation is its own inverse */
+void interleave_frame(uint8_t *buf, size_t len);
+
+#define NRNSC_STATE_INIT    0
+/* NRNSC encode len octets, 16 coded bits each to out; returns next state */
+uint8_t nrnsc_encode(uint8_t *out, const uint8_t *in, size_t len, uint8_t state);
+/* tail and pad after phr_psdu_len encoded octets; returns octets written, 2 or 4 */
+size_t nrnsc_encode_tail(uint8_t *out, size_t phr_psdu_len, uint8_t state);
+
+/* 32 soft coded bits of one interleaver block back to encoder order */
+void deinterleave_soft(int8_t *out, const int8_t *in);
+
+/* Soft decision Viterbi decoder for the NRNSC code. Soft coded bits are in
+ * encoder order (ui1, ui0 per input bit), positive for a one over the air,
+ * magnitude at most 127. */
+#define NRNSC_STATES        8
+#define NRNSC_STATE_END     3       // after tail and pad, 0x0b & 7
+void nrnsc_viterbi_init(int16_t metric[NRNSC_STATES], uint8_t state);
+/* nbits trellis steps from 2*nbits soft bits, one decision octet per step */
+void nrnsc_viterbi_acs(int16_t metric[NRNSC_STATES], uint8_t *decisions,
+    const int8_t *soft, size_t nbits);
+uint8_t nrnsc_viterbi_best(const int16_t metric[NRNSC_STATES]);
+/* nbits decoded bits, MSbit first, of the path ending in state */
+void nrnsc_viterbi_traceback(uint8_t *out, const uint8_t *decisions, size_t nbits, uint8_t state);
+
+#define PN9_SEED        0x1ff
+#define PN9_PERIOD      511     // octets, then sequence repeats
+extern const uint8_t pn9_table[PN9_PERIOD];
+
 uint8_t get_pn9_byte(uint16_t *);
+/* whiten or de-whiten buf in place, lfsr is advanced past len octets */
+void pn9_xor(uint8_t *buf, size_t len, uint16_t *lfsr);
+
+#define PN15_SEED       0x7fff
+#define PN15_PERIOD     32767   // octets, then sequence repeats
+/* first len octets of PN15 from seed */
+void pn15_generate(uint8_t *buf, size_t len);
 uint8_t reverse_octet(uint8_t);
 
+/* octets over the air for payload_len octets of payload (excluding FCS) */
+size_t mrfsk_frame_length(int preamble_size, int fec_en, int crc_type_16, size_t payload_len);
+/* preamble, SFD, PHR, payload + FCS, whitened and FEC coded per flags, into ota.
+ * payload_len excludes FCS. Returns over-the-air length, or -1 if it won't fit. */
+int mrfsk_encode_frame(uint8_t *ota, size_t ota_size, int preamble_size,
+    int fec_en, int dw, int crc_type_16,
+    const uint8_t *payload, size_t payload_len);
+
+/* Preamble detector, per 2-UI window of len samples: min and max with the
+ * index of the first of each, -1 if none past the initial values; zeros
+ * when every sample is zero (squelched) */
+#define PREAMBLE_WINDOW_MIN     1000.0f
+#define PREAMBLE_WINDOW_MAX     -1000.0f
+typedef struct {
+    float min_val;
+    float max_val;
+    int min_at;
+    int max_at;
+    int zeros;
+} preamble_window_t;
+
+/* nonzero when the AVX2 kernels are used on this CPU */
+int cpu_has_avx2(void);
+
+/* nwin consecutive windows */
+void preamble_windows(preamble_window_t *out, const float *in, int len, int nwin);
+/* last index n where in[n-1], in[n] cross mid upward (zcu_at) and downward
+ * (zcd_at), -1 if none; in[-1] is read unless first */
+void preamble_crossings(const float *in, int len, float mid, int first,
+    int *zcu_at, int *zcd_at);
+
+/* cubic Lagrange (Farrow) interpolation at x[0] + mu, 0 <= mu < 1; reads
+ * x[-1] through x[2] */
+static inline float
+farrow_cubic(const float *x, float mu)
+{
+    float c1 = x[1] - x[-1] / 3.0f - x[0] / 2.0f - x[2] / 6.0f;
+    float c2 = (x[-1] + x[1]) / 2.0f - x[0];
+    float c3 = (x[2] - x[-1]) / 6.0f + (x[0] - x[1]) / 2.0f;
+
+    return ((c3 * mu + c2) * mu + c1) * mu + x[0];
+}
+
 #ifdef __cplusplus
 }
 #endif
 
+#endif /* INCLUDED_IEEE802154G_UTILS_MRFSK_H */
@@ -44,18 +44,16 @@ class mrfsk_pkt_sink(gr.hier_block2):
         )
 
         msgq = gr.msg_queue(DEFAULT_MSGQ_LIMIT) # holds packets from the PHY
-        ## last nibble of preamble, and 0x904e for SFD uncoded packet
-        # last byte of preamble, and 0x904e for SFD uncoded packet
-        # add more preamble to this if excessive false triggering
-        correlator       = digital.correlate_access_code_bb('0101010101011001000001001110', 1)
-        correlator_nrnsc = digital.correlate_access_code_bb('0101010101010110111101001110', 2)
-        framer_sink = ieee802154g.framer_sink_mrfsk(msgq)
-        framer_sink_nrnsc = ieee802154g.framer_sink_mrfsk_nrnsc(msgq)
+        # last 12 preamble bits and SFD, 0x904e uncoded or 0x6f4e FEC, found
+        # in one pass; add more preamble to this if excessive false triggering.
+        # Bit errors allowed as before: 1 with uncoded SFD, 2 with FEC
+        deframer = ieee802154g.mrfsk_deframer(msgq, 12, 1, 2)
+        # printing thread falling behind drops frames, never stalls receive
+        deframer.set_lossy(True)
         #connect
-        self.connect(self, correlator, framer_sink)
-        self.connect(self, correlator_nrnsc, framer_sink_nrnsc)
+        self.connect(self, deframer)
         #start thread
-        _packet_decoder_thread(msgq)
+        _packet_decoder_thread(msgq, deframer)
 
 
     def work(self, input_items, output_items):
@@ -66,15 +64,13 @@ class mrfsk_pkt_sink(gr.hier_block2):
 
 class _packet_decoder_thread(_threading.Thread):
 
-    def __init__(self, msgq):
+    def __init__(self, msgq, deframer):
         _threading.Thread.__init__(self)
         self.setDaemon(1)
         self._msgq = msgq
+        self._deframer = deframer
         self.keep_running = True
 
-        self.pkts_good = 0
-        self.pkts_bad = 0
-
         self.start()
 
     def run(self):
@@ -89,13 +85,11 @@ class _packet_decoder_thread(_threading.Thread):
                 print "dw ",
             crc_ok = int(msg.arg2())
             if crc_ok == 1:
-                self.pkts_good += 1
                 if phr & 0x1000:
                     print "CRC16-ok    ",
                 else:
                     print "crc32-ok    ",
             else:
-                self.pkts_bad += 1
                 if phr & 0x1000:
                     print "[41mCRC16-fail    ",
                 else:
@@ -105,5 +99,8 @@ class _packet_decoder_thread(_threading.Thread):
             print ' '.join(x.encode('hex') for x in s)
             if crc_ok == 0:
                 print "[0m",
-            print "good:%d, bad:%d" % (self.pkts_good, self.pkts_bad)
+            # counted by the deframer, so frames dropped here are in too
+            d = self._deframer
+            print "good:%d, bad:%d, dropped:%d" % (d.crc16_ok() + d.crc32_ok(),
+                d.crc16_fail() + d.crc32_fail(), d.dropped())
 
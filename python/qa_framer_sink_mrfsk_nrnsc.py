@@ -20,6 +20,7 @@
 # 
 
 from gnuradio import gr, gr_unittest, blocks, digital
+import pmt
 import ieee802154g_swig as ieee802154g
 
 def hex_list_to_binary_list(s):
@@ -30,6 +31,10 @@ def hex_list_to_binary_list(s):
             r.append(t)
     return r;
 
+def binary_list_to_packed(bits):
+    bits = bits + [0] * (-len(bits) % 8)
+    return [sum(b << (7-i) for i, b in enumerate(bits[n:n+8])) for n in range(0, len(bits), 8)]
+
 class qa_framer_sink_mrfsk_nrnsc (gr_unittest.TestCase):
 
     def setUp (self):
@@ -74,5 +79,37 @@ class qa_framer_sink_mrfsk_nrnsc (gr_unittest.TestCase):
 
     #TODO: insert some error bits into src_data 
 
+    def test_002_t (self):
+        # packed input, first bit after SFD at bit 0 and at bit 3 of its octet
+        for lead in (0, 3):
+            pad = (0xff,) * 8
+            src_data = pad + ( 0x55, 0x55, 0x55, 0x55, 0x6f, 0x4e,
+            0xbf, 0x7f, 0x3f, 0xff, 0xfc, 0xfd, 0xfc, 0xf2, 0x37, 0xaa,
+            0xbc, 0xb7, 0x5e, 0x13, 0xa4, 0x5d, 0xb2, 0xf0, 0xb4, 0x3c) + pad
+            # SFD ends 14 octets in, the frame is pushed lead bits further
+            src_data_list = [1] * lead + hex_list_to_binary_list(src_data)
+            expected_str = '\x40\x00\x56\x5d\x29\xfa\x28'
+
+            tag = gr.tag_t()
+            tag.offset = (14 * 8 + lead) // 8
+            tag.key = pmt.intern("sfd")
+            tag.value = pmt.from_long((14 * 8 + lead) % 8)
+            rcvd_pktq = gr.msg_queue()
+
+            src = blocks.vector_source_b(binary_list_to_packed(src_data_list), False, 1, [tag])
+            framer_sink = ieee802154g.framer_sink_mrfsk_nrnsc(rcvd_pktq, "sfd")
+
+            self.tb = gr.top_block ()
+            self.tb.connect(src, framer_sink)
+            self.tb.run ()
+
+            # check data
+            self.assertEquals(1, rcvd_pktq.count())
+            result_msg = rcvd_pktq.delete_head()
+            self.assertEquals(1, int(result_msg.type()))
+            self.assertEquals(0x0007, int(result_msg.arg1()))
+            self.assertEquals(1, int(result_msg.arg2()))
+            self.assertEquals(expected_str, result_msg.to_string())
+
 if __name__ == '__main__':
     gr_unittest.run(qa_framer_sink_mrfsk_nrnsc, "qa_framer_sink_mrfsk_nrnsc.xml")
@@ -0,0 +1,178 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# 
+# Copyright 2013 wroberts92780@gmail.com
+# 
+# This is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# This software is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this software; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+
+from gnuradio import gr, gr_unittest, blocks
+import pmt
+import ieee802154g_swig as ieee802154g
+
+def hex_list_to_binary_list(s):
+    r = []
+    for e in s:
+        for i in range(8):
+            t = (e >> (7-i)) & 0x1
+            r.append(t)
+    return r;
+
+class qa_mrfsk_deframer (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+
+    def tearDown (self):
+        self.tb = None
+
+    pad = (0xff,) * 8
+    # CRC-32 test from section 5.2.1.9 in 802.15.4g-2012
+    uncoded = (0x55, 0x55, 0x55, 0x55, 0x90, 0x4e, 0x00, 0x07, 0x40, 0x00, 0x56, 0x5d, 0x29, 0xfa, 0x28)
+    # Annex O example 4, NRNSC with 0x6f4e SFD
+    nrnsc = ( 0x55, 0x55, 0x55, 0x55, 0x6f, 0x4e,
+        0xbf, 0x7f, 0x3f, 0xff, 0xfc, 0xfd, 0xfc, 0xf2, 0x37, 0xaa,
+        0xbc, 0xb7, 0x5e, 0x13, 0xa4, 0x5d, 0xb2, 0xf0, 0xb4, 0x3c)
+    expected_str = '\x40\x00\x56\x5d\x29\xfa\x28'
+
+    def run_deframer (self, src_data_list, threshold):
+        rcvd_pktq = gr.msg_queue()
+        src = blocks.vector_source_b(src_data_list)
+        deframer = ieee802154g.mrfsk_deframer(rcvd_pktq, 12, threshold)
+        self.tb.connect(src, deframer)
+        self.tb.run ()
+        return rcvd_pktq
+
+    def test_001_t (self):
+        # uncoded and FEC frames in one stream, each decoded its own way
+        src_data = self.pad + self.uncoded + self.pad + self.nrnsc + self.pad
+        rcvd_pktq = self.run_deframer(hex_list_to_binary_list(src_data), 1)
+
+        self.assertEquals(2, rcvd_pktq.count())
+        for fec in (0, 1):
+            result_msg = rcvd_pktq.delete_head()
+            self.assertEquals(fec, int(result_msg.type()))
+            self.assertEquals(0x0007, int(result_msg.arg1()))
+            self.assertEquals(1, int(result_msg.arg2()))
+            self.assertEquals(self.expected_str, result_msg.to_string())
+
+    def test_002_t (self):
+        # bit errors in SFD: two are within threshold, three are not
+        src_data_list = hex_list_to_binary_list(self.pad + self.uncoded + self.pad + self.nrnsc + self.pad)
+        sfd_uncoded = (8 + 4) * 8
+        sfd_nrnsc = (8 + 15 + 8 + 4) * 8
+        for n in (3, 5, 7):
+            src_data_list[sfd_uncoded + n] ^= 1
+        for n in (9, 12):
+            src_data_list[sfd_nrnsc + n] ^= 1
+        rcvd_pktq = self.run_deframer(src_data_list, 2)
+
+        self.assertEquals(1, rcvd_pktq.count())
+        result_msg = rcvd_pktq.delete_head()
+        self.assertEquals(1, int(result_msg.type()))
+        self.assertEquals(1, int(result_msg.arg2()))
+        self.assertEquals(self.expected_str, result_msg.to_string())
+
+    def test_003_t (self):
+        # PDUs on message port; queue of one in lossy mode drops the second frame
+        src_data = self.pad + self.uncoded + self.pad + self.nrnsc + self.pad
+        rcvd_pktq = gr.msg_queue(1)
+        src = blocks.vector_source_b(hex_list_to_binary_list(src_data))
+        deframer = ieee802154g.mrfsk_deframer(rcvd_pktq, 12, 1)
+        deframer.set_lossy(True)
+        dbg = blocks.message_debug()
+        self.tb.connect(src, deframer)
+        self.tb.msg_connect(deframer, "pdus", dbg, "store")
+        self.tb.run ()
+
+        self.assertEquals(1, rcvd_pktq.count())
+        self.assertEquals(1, deframer.dropped())
+        self.assertEquals(2, dbg.num_messages())
+        for n in range(2):
+            pdu = dbg.get_message(n)
+            meta = pmt.car(pdu)
+            self.assertEquals(n == 1, pmt.to_bool(pmt.dict_ref(meta, pmt.intern("fec_en"), pmt.PMT_NIL)))
+            self.assertTrue(pmt.to_bool(pmt.dict_ref(meta, pmt.intern("crc_ok"), pmt.PMT_NIL)))
+            self.assertEquals(0x0007, pmt.to_long(pmt.dict_ref(meta, pmt.intern("phr"), pmt.PMT_NIL)))
+            self.assertEquals(7, pmt.to_long(pmt.dict_ref(meta, pmt.intern("length"), pmt.PMT_NIL)))
+            # PSDU without 4 octet FCS
+            self.assertEquals((0x40, 0x00, 0x56), tuple(pmt.u8vector_elements(pmt.cdr(pdu))))
+
+    def test_004_t (self):
+        # false sync with a maximum length PHR ahead of a real frame
+        bogus = (0x55, 0x55, 0x55, 0x55, 0x90, 0x4e, 0x07, 0xff)
+        src_data_list = hex_list_to_binary_list(self.pad + bogus + self.pad + self.uncoded + self.pad)
+        for max_length, preempt, count in ((2047, False, 0), (2047, True, 1), (100, False, 1)):
+            self.tb = gr.top_block ()
+            rcvd_pktq = gr.msg_queue()
+            src = blocks.vector_source_b(src_data_list)
+            deframer = ieee802154g.mrfsk_deframer(rcvd_pktq, 12, 1)
+            deframer.set_max_frame_length(max_length)
+            deframer.set_preempt(preempt)
+            self.tb.connect(src, deframer)
+            self.tb.run ()
+
+            self.assertEquals(count, rcvd_pktq.count())
+            if count:
+                self.assertEquals(self.expected_str, rcvd_pktq.delete_head().to_string())
+
+    def test_005_t (self):
+        # counters: one frame of each code, one FCS error, one bad PHR
+        bad_fcs = self.uncoded[:-1] + (self.uncoded[-1] ^ 1,)
+        bogus = (0x55, 0x55, 0x55, 0x55, 0x90, 0x4e, 0x87, 0xff)
+        src_data = self.pad + self.uncoded + self.pad + bad_fcs + self.pad + \
+            self.nrnsc + self.pad + bogus + self.pad
+        rcvd_pktq = gr.msg_queue()
+        src = blocks.vector_source_b(hex_list_to_binary_list(src_data))
+        deframer = ieee802154g.mrfsk_deframer(rcvd_pktq, 12, 1)
+        self.tb.connect(src, deframer)
+        self.tb.run ()
+
+        self.assertEquals(3, deframer.sfd_uncoded())
+        self.assertEquals(1, deframer.sfd_nrnsc())
+        self.assertEquals(1, deframer.phr_rejects())
+        self.assertEquals(2, deframer.crc32_ok())
+        self.assertEquals(1, deframer.crc32_fail())
+        self.assertEquals(0, deframer.crc16_ok() + deframer.crc16_fail())
+        self.assertEquals(3 * 3, deframer.octets())
+        self.assertEquals(0, deframer.dropped())
+
+    def test_006_t (self):
+        # thresholds per SFD, 1 uncoded and 2 NRNSC: an uncoded SFD with
+        # two bit errors is missed, with one it is found, as is NRNSC with two
+        src_data_list = hex_list_to_binary_list(self.pad + self.uncoded + self.pad +
+            self.nrnsc + self.pad + self.uncoded + self.pad)
+        for n in (3, 5):
+            src_data_list[(8 + 4) * 8 + n] ^= 1
+        for n in (9, 12):
+            src_data_list[(8 + 15 + 8 + 4) * 8 + n] ^= 1
+        src_data_list[(8 + 15 + 8 + 26 + 8 + 4) * 8 + 6] ^= 1
+        rcvd_pktq = gr.msg_queue()
+        src = blocks.vector_source_b(src_data_list)
+        deframer = ieee802154g.mrfsk_deframer(rcvd_pktq, 12, 1, 2)
+        self.tb.connect(src, deframer)
+        self.tb.run ()
+
+        self.assertEquals(2, rcvd_pktq.count())
+        for fec in (1, 0):
+            result_msg = rcvd_pktq.delete_head()
+            self.assertEquals(fec, int(result_msg.type()))
+            self.assertEquals(1, int(result_msg.arg2()))
+            self.assertEquals(self.expected_str, result_msg.to_string())
+
+if __name__ == '__main__':
+    gr_unittest.run(qa_mrfsk_deframer, "qa_mrfsk_deframer.xml")
@@ -0,0 +1,56 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# 
+# Copyright 2013 wroberts92780@gmail.com
+# 
+# This is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# This software is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this software; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+from gnuradio import gr, gr_unittest, blocks, digital
+import ieee802154g_swig as ieee802154g
+import math
+
+class qa_mrfsk_mod (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+
+    def tearDown (self):
+        self.tb = None
+
+    def run_both (self, sps, h, rm, steps, fec_en):
+        # mrfsk_mod against the gfsk_mod -> pa_ramp chain it replaces
+        src = ieee802154g.mrfsk_source(2, 4, fec_en, True, False, 0, 20, 3)
+        head = blocks.head(gr.sizeof_char, 200)
+        gfsk = digital.gfsk_mod(sps, math.pi * h / sps, 0.5)
+        ramp = ieee802154g.pa_ramp(rm, steps)
+        mod = ieee802154g.mrfsk_mod(sps, h, 0.5, rm, steps)
+        dst_ref = blocks.vector_sink_c()
+        dst = blocks.vector_sink_c()
+        self.tb.connect(src, head, gfsk, ramp, dst_ref)
+        self.tb.connect(head, mod, dst)
+        self.tb.run ()
+        self.assertEqual(len(dst_ref.data()), len(dst.data()))
+        self.assertComplexTuplesAlmostEqual(dst_ref.data(), dst.data(), 3)
+
+    def test_001_t (self):
+        self.run_both(10, 1.0, 1.0, 4, False)
+
+    def test_002_t (self):
+        self.run_both(8, 0.5, 0.7, 20, True)
+
+if __name__ == '__main__':
+    gr_unittest.run(qa_mrfsk_mod, "qa_mrfsk_mod.xml")
@@ -0,0 +1,73 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# 
+# Copyright 2013 wroberts92780@gmail.com
+# 
+# This is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# This software is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this software; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+from gnuradio import gr, gr_unittest, blocks
+import ieee802154g_swig as ieee802154g
+import cmath, math
+
+class qa_mrfsk_multi_source (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+
+    def tearDown (self):
+        self.tb = None
+
+    def run_both (self, sps, offset, fec_en, nsamples):
+        # one channel against the mrfsk_source -> mrfsk_mod chain, shifted
+        samp_rate = 50e3 * sps
+        src = ieee802154g.mrfsk_source(0, 4, fec_en, True, False, 0, 20, 3)
+        mod = ieee802154g.mrfsk_mod(sps, 1.0, 0.5, 0.8, 4)
+        multi = ieee802154g.mrfsk_multi_source(sps, 1.0, 0.5, samp_rate, [offset],
+                4, fec_en, True, False, 20, 3, 0.8, 4)
+        head_ref = blocks.head(gr.sizeof_gr_complex, nsamples)
+        head = blocks.head(gr.sizeof_gr_complex, nsamples)
+        dst_ref = blocks.vector_sink_c()
+        dst = blocks.vector_sink_c()
+        self.tb.connect(src, mod, head_ref, dst_ref)
+        self.tb.connect(multi, head, dst)
+        self.tb.run ()
+        w = 2 * math.pi * offset / samp_rate
+        ref = [x * cmath.exp(1j * w * n) for n, x in enumerate(dst_ref.data())]
+        self.assertEqual(len(ref), len(dst.data()))
+        self.assertComplexTuplesAlmostEqual(ref, dst.data(), 3)
+
+    def test_001_t (self):
+        self.run_both(8, 0, False, 20000)
+
+    def test_002_t (self):
+        self.run_both(4, -37e3, True, 20000)
+
+    def test_003_t (self):
+        # channel 0 keys up after the startup delay, the others later
+        multi = ieee802154g.mrfsk_multi_source(4, 1.0, 0.5, 200e3, [-60e3, 0, 60e3],
+                4, False, True, False, 20, 3, 1.0, 4)
+        head = blocks.head(gr.sizeof_gr_complex, 40000)
+        dst = blocks.vector_sink_c()
+        self.tb.connect(multi, head, dst)
+        self.tb.run ()
+        data = dst.data()
+        first = [n for n, x in enumerate(data) if abs(x) > 0][0]
+        self.assertEqual(first, 50 * 8 * 4)
+        self.assertTrue(max(abs(x) for x in data) > 1.0)
+
+if __name__ == '__main__':
+    gr_unittest.run(qa_mrfsk_multi_source, "qa_mrfsk_multi_source.xml")
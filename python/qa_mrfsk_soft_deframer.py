@@ -0,0 +1,73 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# 
+# Copyright 2013 wroberts92780@gmail.com
+# 
+# This is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# This software is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this software; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+
+from gnuradio import gr, gr_unittest, blocks
+import ieee802154g_swig as ieee802154g
+
+def hex_list_to_soft_list(s):
+    r = []
+    for e in s:
+        for i in range(8):
+            r.append(1.0 if (e >> (7-i)) & 0x1 else -1.0)
+    return r;
+
+class qa_mrfsk_soft_deframer (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+
+    def tearDown (self):
+        self.tb = None
+
+    pad = (0xff,) * 8
+    # CRC-32 test from section 5.2.1.9 in 802.15.4g-2012
+    uncoded = (0x55, 0x55, 0x55, 0x55, 0x90, 0x4e, 0x00, 0x07, 0x40, 0x00, 0x56, 0x5d, 0x29, 0xfa, 0x28)
+    # Annex O example 4, NRNSC with 0x6f4e SFD
+    nrnsc = ( 0x55, 0x55, 0x55, 0x55, 0x6f, 0x4e,
+        0xbf, 0x7f, 0x3f, 0xff, 0xfc, 0xfd, 0xfc, 0xf2, 0x37, 0xaa,
+        0xbc, 0xb7, 0x5e, 0x13, 0xa4, 0x5d, 0xb2, 0xf0, 0xb4, 0x3c)
+    expected_str = '\x40\x00\x56\x5d\x29\xfa\x28'
+
+    def test_001_t (self):
+        # uncoded and FEC frames in one stream; in the FEC frame seven coded
+        # bits are wrong but weak, which only soft decisions can correct
+        src_data_list = hex_list_to_soft_list(self.pad + self.uncoded + self.pad + self.nrnsc + self.pad)
+        coded = (8 + 15 + 8 + 6) * 8
+        for n in (3, 21, 50, 77, 100, 130, 151):
+            src_data_list[coded + n] *= -0.25
+
+        rcvd_pktq = gr.msg_queue()
+        src = blocks.vector_source_f(src_data_list)
+        deframer = ieee802154g.mrfsk_soft_deframer(rcvd_pktq, 12, 1)
+        self.tb.connect(src, deframer)
+        self.tb.run ()
+
+        self.assertEquals(2, rcvd_pktq.count())
+        for fec in (0, 1):
+            result_msg = rcvd_pktq.delete_head()
+            self.assertEquals(fec, int(result_msg.type()))
+            self.assertEquals(0x0007, int(result_msg.arg1()))
+            self.assertEquals(1, int(result_msg.arg2()))
+            self.assertEquals(self.expected_str, result_msg.to_string())
+
+if __name__ == '__main__':
+    gr_unittest.run(qa_mrfsk_soft_deframer, "qa_mrfsk_soft_deframer.xml")
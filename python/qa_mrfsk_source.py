@@ -35,6 +35,8 @@ class tag_sink(gr.sync_block):
         )
         self.tx_on_at = -1
         self.tx_off_at = -1
+        self.tx_on = []
+        self.tx_off = []
 
     def work(self, input_items, output_items):
         num_input_items = len(input_items[0])
@@ -45,14 +47,101 @@ class tag_sink(gr.sync_block):
                 tx_on = pmt.to_long(tag.value)
                 if tx_on == 1:
                     self.tx_on_at = tag.offset
+                    self.tx_on.append(tag.offset)
                 else:
                     self.tx_off_at = tag.offset
+                    self.tx_off.append(tag.offset)
                 
 
         return num_input_items
 
+def pn_octets(nbits, taps, n):
+    # Fibonacci LFSR from all ones, output MSbit first
+    lfsr = (1 << nbits) - 1
+    ret = []
+    for i in range(n):
+        octet = 0
+        for b in range(8):
+            xor_out = ((lfsr >> taps) ^ lfsr) & 1
+            lfsr = (lfsr >> 1) | (xor_out << (nbits - 1))
+            octet = (octet << 1) | ((lfsr >> (nbits - 1)) & 1)
+        ret.append(octet)
+    return tuple(ret)
+
+def reverse_octet(x):
+    return int('{0:08b}'.format(x & 0xff)[::-1], 2)
+
+def incr_payload(n):
+    # PAYLOAD_TYPE_INCR_BYTE content, so frames compare with generated ones
+    return tuple(reverse_octet(i) for i in range(n))
+
+def ref_frame(preamble_size, n, fec_en):
+    # over-the-air frame of incr_payload(n), from the packet generator
+    tb = gr.top_block ()
+    pkt_src = ieee802154g.mrfsk_source(1, preamble_size, fec_en, False, False, 0, n + 4, 0)
+    dst = blocks.vector_sink_b()
+    tsink = tag_sink()
+    tb.connect(pkt_src, dst)
+    tb.connect(pkt_src, tsink)
+    tb.run ()
+    return dst.data()[tsink.tx_on_at:tsink.tx_off_at-1]
+
+class pdu_feeder(gr.sync_block):
+    # Posts PDUs to mrfsk_source, no more than max_queued ahead of the
+    # frames coming back. Input is taken only up to the end of each frame
+    # back, so the source never gets further ahead than its output buffer
+    # and PDUs arrive with frames still queued.
+    def __init__(self, pdus, max_queued):
+        gr.sync_block.__init__(
+            self,
+            name = "pdu feeder",
+            in_sig = [numpy.uint8],
+            out_sig = None
+        )
+        self.message_port_register_out(pmt.intern("pdus"))
+        self.pdus = pdus
+        self.max_queued = max_queued
+        self.sent = 0
+        self.data = []
+        self.tx_on = []
+        self.tx_off = []
+
+    def work(self, input_items, output_items):
+        n = len(input_items[0])
+        nread = self.nitems_read(0)
+        tags = self.get_tags_in_range(0, nread, nread+n, pmt.intern("pa_ramp"))
+        for tag in sorted(tags, key=lambda t: t.offset):
+            if pmt.to_long(tag.value) == 1:
+                self.tx_on.append(tag.offset)
+            else:
+                self.tx_off.append(tag.offset)
+                n = tag.offset + 1 - nread
+                break
+        self.data.extend(input_items[0][:n])
+        if len(self.tx_off) == len(self.pdus):
+            return -1
+        while self.sent < len(self.pdus) and self.sent - len(self.tx_off) < self.max_queued:
+            (meta, payload) = self.pdus[self.sent]
+            self.message_port_pub(pmt.intern("pdus"),
+                pmt.cons(meta, pmt.init_u8vector(len(payload), payload)))
+            self.sent += 1
+        return n
+
 class qa_mrfsk_source (gr_unittest.TestCase):
 
+    def run_pdus (self, pkt_src, lengths, preamble_size):
+        # lengths through the frame queue, every frame checked octet for octet
+        feeder = pdu_feeder([(pmt.PMT_NIL, incr_payload(n)) for n in lengths], 4)
+        pkt_src.set_max_output_buffer(4096)
+        self.tb.connect(pkt_src, feeder)
+        self.tb.msg_connect(feeder, "pdus", pkt_src, "pdus")
+        self.tb.run ()
+        self.assertEqual(0, pkt_src.pdus_dropped())
+        self.assertEqual(len(lengths), len(feeder.tx_off))
+        for i in range(len(lengths)):
+            self.assertEqual(ref_frame(preamble_size, lengths[i], False),
+                tuple(feeder.data[feeder.tx_on[i]:feeder.tx_off[i]-1]))
+
     def setUp (self):
         self.tb = gr.top_block ()
 
@@ -159,5 +248,219 @@ class qa_mrfsk_source (gr_unittest.TestCase):
         #print expected_results 
         self.assertEqual(expected_results, result_txon)
 
+    def test_005_t (self):
+        # settings changed after construction: same frame as test_001_t
+        pkt_src = ieee802154g.mrfsk_source(
+            1,      #num_iterations
+            1,      #preamble_size
+            True,   #fec_en
+            True,   #dw
+            True,   #crc_type_16
+            0,      #payload_type (incrementing byte)
+            20,     #psdu_len
+            0       #delay_bytes
+        )
+        pkt_src.set_preamble_size(4)
+        pkt_src.set_fec_en(False)
+        pkt_src.set_dw(False)
+        pkt_src.set_crc_type_16(False)
+        pkt_src.set_payload_type(2)
+        pkt_src.set_delay_bytes(10)
+        dst = blocks.vector_sink_b()
+        tsink = tag_sink()
+        expected_results = (0x55, 0x55, 0x55, 0x55, 0x90, 0x4e, 0x00, 0x07, 0x40, 0x00, 0x56, 0x5d, 0x29, 0xfa, 0x28)
+
+        self.tb.connect(pkt_src, dst)
+        self.tb.connect(pkt_src, tsink)
+        self.tb.run ()
+        result = dst.data()
+        result_txon = result[tsink.tx_on_at:tsink.tx_off_at-1];
+        self.assertEqual(expected_results, result_txon)
+
+    def test_006_t (self):
+        # PDUs: 0x400056 with block settings, then with FEC from metadata
+        pkt_src = ieee802154g.mrfsk_source(
+            4,      #preamble_size
+            False,  #fec_en
+            False,  #dw
+            False,  #crc_type_16
+            0,      #delay_bytes
+            4       #queue_depth
+        )
+        payload = pmt.init_u8vector(3, (0x40, 0x00, 0x56))
+        pkt_src.to_basic_block()._post(pmt.intern("pdus"), pmt.cons(pmt.PMT_NIL, payload))
+        meta = pmt.dict_add(pmt.make_dict(), pmt.intern("fec_en"), pmt.PMT_T)
+        pkt_src.to_basic_block()._post(pmt.intern("pdus"), pmt.cons(meta, payload))
+        head = blocks.head(gr.sizeof_char, 200)
+        dst = blocks.vector_sink_b()
+        tsink = tag_sink()
+        expected_uncoded = (0x55, 0x55, 0x55, 0x55, 0x90, 0x4e, 0x00, 0x07, 0x40, 0x00, 0x56, 0x5d, 0x29, 0xfa, 0x28)
+        expected_coded = ( 0x55, 0x55, 0x55, 0x55, 0x6f, 0x4e,
+            0xbf, 0x7f, 0x3f, 0xff, 0xfc, 0xfd, 0xfc, 0xf2, 0x37, 0xaa,
+            0xbc, 0xb7, 0x5e, 0x13, 0xa4, 0x5d, 0xb2, 0xf0, 0xb4, 0x3c)
+
+        self.tb.connect(pkt_src, head, dst)
+        self.tb.connect(head, tsink)
+        self.tb.run ()
+        result = dst.data()
+        self.assertEqual(2, len(tsink.tx_on))
+        self.assertEqual(expected_uncoded, result[tsink.tx_on[0]:tsink.tx_off[0]-1])
+        self.assertEqual(expected_coded, result[tsink.tx_on[1]:tsink.tx_off[1]-1])
+        # idle after the queue drains
+        self.assertEqual((0,) * 10, result[-10:])
+
+    def test_007_t (self):
+        # continuous PN9 and PN15, across the period wrap
+        for payload_type, nbits, taps, period in ((3, 9, 5, 511), (4, 15, 1, 32767)):
+            self.tb = gr.top_block ()
+            pkt_src = ieee802154g.mrfsk_source(1, 4, False, False, False, payload_type, 0, 0)
+            head = blocks.head(gr.sizeof_char, period + 1000)
+            dst = blocks.vector_sink_b()
+            tsink = tag_sink()
+            self.tb.connect(pkt_src, head, dst)
+            self.tb.connect(head, tsink)
+            self.tb.run ()
+            result = dst.data()
+            self.assertEqual(0, tsink.tx_on_at)
+            self.assertEqual(pn_octets(nbits, taps, period + 1000), result)
+
+    def test_008_t (self):
+        # burst mode: only frames streamed, tagged for UHD sink, timed from start_time
+        pkt_src = ieee802154g.mrfsk_source(
+            2,      #num_iterations
+            4,      #preamble_size
+            False,  #fec_en
+            False,  #dw
+            False,  #crc_type_16
+            2,      #payload_type (0x400056)
+            7,      #psdu_len  (ignored with payload_type=2)
+            100     #delay_bytes
+        )
+        pkt_src.set_burst_mode(True, 50e3, 2.5)
+        dst = blocks.vector_sink_b()
+        frame = (0x55, 0x55, 0x55, 0x55, 0x90, 0x4e, 0x00, 0x07, 0x40, 0x00, 0x56, 0x5d, 0x29, 0xfa, 0x28)
+
+        self.tb.connect(pkt_src, dst)
+        self.tb.run ()
+        self.assertEqual((frame + (0, 0)) * 2, dst.data())
+
+        tags = {}
+        for tag in dst.tags():
+            tags.setdefault(pmt.symbol_to_string(tag.key), []).append(tag)
+        self.assertEqual([0, 17], [t.offset for t in tags['tx_sob']])
+        self.assertEqual([16, 33], [t.offset for t in tags['tx_eob']])
+        self.assertEqual([17, 17], [pmt.to_long(t.value) for t in tags['packet_len']])
+        # next burst starts (17 + 100) octets of 8 symbols later
+        t = [pmt.to_uint64(pmt.tuple_ref(x.value, 0)) + pmt.to_double(pmt.tuple_ref(x.value, 1)) for x in tags['tx_time']]
+        self.assertAlmostEqual(2.5, t[0])
+        self.assertAlmostEqual(2.5 + 117 * 8 / 50e3, t[1])
+
+    def test_009_t (self):
+        # burst mode from PDUs: each queued frame one burst, then nothing
+        # until the next PDU; head ends the flowgraph with the queue empty
+        pkt_src = ieee802154g.mrfsk_source(
+            4,      #preamble_size
+            False,  #fec_en
+            False,  #dw
+            False,  #crc_type_16
+            0,      #delay_bytes
+            4       #queue_depth
+        )
+        pkt_src.set_burst_mode(True, 50e3, 0)
+        payload = pmt.init_u8vector(3, (0x40, 0x00, 0x56))
+        meta = pmt.dict_add(pmt.make_dict(), pmt.intern("fec_en"), pmt.PMT_T)
+        for m in (pmt.PMT_NIL, meta, pmt.PMT_NIL):
+            pkt_src.to_basic_block()._post(pmt.intern("pdus"), pmt.cons(m, payload))
+        uncoded = (0x55, 0x55, 0x55, 0x55, 0x90, 0x4e, 0x00, 0x07, 0x40, 0x00, 0x56, 0x5d, 0x29, 0xfa, 0x28)
+        coded = ( 0x55, 0x55, 0x55, 0x55, 0x6f, 0x4e,
+            0xbf, 0x7f, 0x3f, 0xff, 0xfc, 0xfd, 0xfc, 0xf2, 0x37, 0xaa,
+            0xbc, 0xb7, 0x5e, 0x13, 0xa4, 0x5d, 0xb2, 0xf0, 0xb4, 0x3c)
+        expected = uncoded + (0, 0) + coded + (0, 0) + uncoded + (0, 0)
+        head = blocks.head(gr.sizeof_char, len(expected))
+        dst = blocks.vector_sink_b()
+
+        self.tb.connect(pkt_src, head, dst)
+        self.tb.run ()
+        self.assertEqual(expected, dst.data())
+
+        tags = {}
+        for tag in dst.tags():
+            tags.setdefault(pmt.symbol_to_string(tag.key), []).append(tag.offset)
+        self.assertEqual([0, 17, 45], tags['tx_sob'])
+        self.assertEqual([16, 44, 61], tags['tx_eob'])
+        self.assertFalse('tx_time' in tags)
+
+    def test_010_t (self):
+        # frame arena: 30 PDUs of 1400 to 2039 octets, four queued at a
+        # time, wrap around the arena of four longest frames several times
+        pkt_src = ieee802154g.mrfsk_source(
+            4,      #preamble_size
+            False,  #fec_en
+            False,  #dw
+            False,  #crc_type_16
+            0,      #delay_bytes
+            4       #queue_depth
+        )
+        self.run_pdus(pkt_src, [1400 + (i * 173) % 640 for i in range(30)], 4)
+
+    def test_011_t (self):
+        # preamble above 32 octets: from make(), and set later over an
+        # arena sized for a shorter one
+        pkt_src = ieee802154g.mrfsk_source(40, False, False, False, 0, 4)
+        self.run_pdus(pkt_src, [1400 + (i * 173) % 640 for i in range(30)], 40)
+
+        self.tb = gr.top_block ()
+        pkt_src = ieee802154g.mrfsk_source(4, False, False, False, 0, 4)
+        pkt_src.set_preamble_size(48)
+        self.run_pdus(pkt_src, [1400 + (i * 173) % 640 for i in range(30)], 48)
+
+        # four longest coded frames at once: the arena, sized for the
+        # shorter preamble, holds three of them
+        self.tb = gr.top_block ()
+        pkt_src = ieee802154g.mrfsk_source(4, False, False, False, 0, 4)
+        pkt_src.set_preamble_size(48)
+        meta = pmt.dict_add(pmt.make_dict(), pmt.intern("fec_en"), pmt.PMT_T)
+        payload = incr_payload(2039)
+        for i in range(4):
+            pkt_src.to_basic_block()._post(pmt.intern("pdus"),
+                pmt.cons(meta, pmt.init_u8vector(len(payload), payload)))
+        head = blocks.head(gr.sizeof_char, 4 * 4200)
+        dst = blocks.vector_sink_b()
+        tsink = tag_sink()
+        self.tb.connect(pkt_src, head, dst)
+        self.tb.connect(head, tsink)
+        self.tb.run ()
+        result = dst.data()
+        frame = ref_frame(48, 2039, True)
+        self.assertEqual(3, len(tsink.tx_on))
+        self.assertEqual(1, pkt_src.pdus_dropped())
+        for i in range(3):
+            self.assertEqual(frame, result[tsink.tx_on[i]:tsink.tx_off[i]-1])
+
+    def test_012_t (self):
+        # out of range settings are clamped: negative preamble to none,
+        # psdu_len to 2047, instead of sending empty frames
+        expected_results = ref_frame(0, 2043, False)
+        self.assertEqual(2 + 2 + 2047, len(expected_results))
+        pkt_src = ieee802154g.mrfsk_source(1, -3, False, False, False, 0, 5000, 0)
+        dst = blocks.vector_sink_b()
+        tsink = tag_sink()
+        self.tb.connect(pkt_src, dst)
+        self.tb.connect(pkt_src, tsink)
+        self.tb.run ()
+        result = dst.data()
+        self.assertEqual(expected_results, result[tsink.tx_on_at:tsink.tx_off_at-1])
+
+        self.tb = gr.top_block ()
+        pkt_src = ieee802154g.mrfsk_source(1, 4, False, False, False, 0, 2047, 0)
+        pkt_src.set_preamble_size(-1)
+        dst = blocks.vector_sink_b()
+        tsink = tag_sink()
+        self.tb.connect(pkt_src, dst)
+        self.tb.connect(pkt_src, tsink)
+        self.tb.run ()
+        result = dst.data()
+        self.assertEqual(expected_results, result[tsink.tx_on_at:tsink.tx_off_at-1])
+
 if __name__ == '__main__':
     gr_unittest.run(qa_mrfsk_source, "qa_mrfsk_source.xml")
@@ -64,6 +64,50 @@ class qa_preamble_detector (gr_unittest.TestCase):
                 pos = not pos
             cnt += 1
 
+    def test_002_t (self):
+        test = ieee802154g.preamble_detector(2)
+
+        # preamble at 2 samples per symbol, sampled half a sample off the peaks:
+        # no input sample exceeds 0.071, only interpolated ones do.
+        num_cycles = 20
+        data = num_cycles * [0.0707, 0.0707, -0.0707, -0.0707]
+        src = blocks.vector_source_f(data, False)
+        snk = blocks.vector_sink_f()
+
+        self.tb.connect(src, test, snk)
+        self.tb.run ()
+
+        dst_data = snk.data()
+        assert len(dst_data) == num_cycles * 2
+        locked = False
+        for cnt, n in enumerate(dst_data):
+            if not locked:
+                if abs(n) > 0.08:
+                    locked = True
+                elif cnt > 24:
+                    assert False, "failed to lock"
+            else:
+                assert abs(n) > 0.08
+                assert (n > 0) != (prev > 0)
+            prev = n
+
+    def test_003_t (self):
+        # 5 preamble cycles then squelch: too short for the default thresholds
+        cycle = [-0.098, -0.064, 0.064, 0.093, 0.081, 0.071, 0.069, 0.065, 0.070, 0.037, -0.087, -0.118, -0.105, -0.101, -0.099, -0.095]
+        data = 5 * cycle + 64 * [0.0]
+        for thresholds, locks in (((3, 6, 4, 0.1), 0), ((1, 2, 4, 0.1), 1)):
+            self.tb = gr.top_block ()
+            test = ieee802154g.preamble_detector(8)
+            test.set_thresholds(*thresholds)
+            src = blocks.vector_source_f(data, False)
+            snk = blocks.vector_sink_f()
+
+            self.tb.connect(src, test, snk)
+            self.tb.run ()
+
+            self.assertEquals(thresholds[1], test.lock_windows())
+            self.assertEquals(locks, test.locks())
+
 
 if __name__ == '__main__':
     gr_unittest.run(qa_preamble_detector, "qa_preamble_detector.xml")
@@ -0,0 +1,76 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# 
+# Copyright 2013 wroberts92780@gmail.com
+# 
+# This is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# This software is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this software; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+from gnuradio import gr, gr_unittest, blocks
+import math
+import ieee802154g_swig as ieee802154g
+
+class qa_preamble_tracker (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+
+    def tearDown (self):
+        self.tb = None
+
+    # 32 symbols of preamble, then 0xcc data, at 8 samples per symbol from
+    # a transmitter 500 ppm slow: 2000 symbols drift 8 samples, one symbol.
+    symbols = [1, -1] * 16 + [1, 1, -1, -1] * 500
+
+    def run_tracker (self, loop_gain):
+        sps = 8 * (1 + 500e-6)
+        data = []
+        for t in range(int((len(self.symbols) - 1) * sps)):
+            k = int(t / sps)
+            f = (1 + math.cos(math.pi * (t / sps - k))) / 2
+            data.append(0.1 * (self.symbols[k] * f + self.symbols[k + 1] * (1 - f)))
+        test = ieee802154g.preamble_tracker(8, loop_gain)
+        src = blocks.vector_source_f(data, False)
+        snk = blocks.vector_sink_f()
+
+        self.tb.connect(src, test, snk)
+        self.tb.run ()
+        return snk.data()
+
+    def bit_errors (self, dst_data):
+        # from lock, against the symbols at the lag the preamble gives
+        first = [abs(n) > 0.08 for n in dst_data].index(True)
+        assert first < 24, "failed to lock"
+        dst = [n > 0 for n in dst_data[first:]]
+        for lag in range(first, first + 4):
+            src = [s > 0 for s in self.symbols[lag:lag + len(dst)]]
+            if dst[:24] == src[:24]:
+                return sum(a != b for a, b in zip(dst, src))
+        assert False, "lost preamble"
+
+    def test_001_t (self):
+        dst_data = self.run_tracker(0.05)
+        assert len(dst_data) > len(self.symbols) - 8
+        self.assertEquals(0, self.bit_errors(dst_data))
+
+    def test_002_t (self):
+        # without tracking the sample point walks off the data
+        dst_data = self.run_tracker(0)
+        assert self.bit_errors(dst_data) > 100
+
+
+if __name__ == '__main__':
+    gr_unittest.run(qa_preamble_tracker, "qa_preamble_tracker.xml")
@@ -13,6 +13,11 @@
 #include "ieee802154g/framer_sink_mrfsk.h"
 #include "ieee802154g/framer_sink_mrfsk_nrnsc.h"
 #include "ieee802154g/preamble_detector.h"
+#include "ieee802154g/preamble_tracker.h"
+#include "ieee802154g/mrfsk_mod.h"
+#include "ieee802154g/mrfsk_multi_source.h"
+#include "ieee802154g/mrfsk_deframer.h"
+#include "ieee802154g/mrfsk_soft_deframer.h"
 %}
 
 
@@ -26,3 +31,13 @@ GR_SWIG_BLOCK_MAGIC2(ieee802154g, framer_sink_mrfsk);
 GR_SWIG_BLOCK_MAGIC2(ieee802154g, framer_sink_mrfsk_nrnsc);
 %include "ieee802154g/preamble_detector.h"
 GR_SWIG_BLOCK_MAGIC2(ieee802154g, preamble_detector);
+%include "ieee802154g/preamble_tracker.h"
+GR_SWIG_BLOCK_MAGIC2(ieee802154g, preamble_tracker);
+%include "ieee802154g/mrfsk_mod.h"
+GR_SWIG_BLOCK_MAGIC2(ieee802154g, mrfsk_mod);
+%include "ieee802154g/mrfsk_multi_source.h"
+GR_SWIG_BLOCK_MAGIC2(ieee802154g, mrfsk_multi_source);
+%include "ieee802154g/mrfsk_deframer.h"
+GR_SWIG_BLOCK_MAGIC2(ieee802154g, mrfsk_deframer);
+%include "ieee802154g/mrfsk_soft_deframer.h"
+GR_SWIG_BLOCK_MAGIC2(ieee802154g, mrfsk_soft_deframer);